@@ -1,8 +1,30 @@
 #pragma once
+#include "Parallel.h"
+#include "Simd.h"
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+// Для указателей на double/float/int32_t/uint32_t с предикатами EqualTo и InRange поиск идет векторными ядрами (Simd.h).
 template<typename _InputIter, typename _UnaryPred>
 _InputIter findIf(_InputIter beg, _InputIter end, _UnaryPred pred) {
+	if constexpr (IsSimdRange<_InputIter>::value) {
+		using ValueType = typename std::remove_cv<typename std::remove_pointer<_InputIter>::type>::type;
+		if constexpr (std::is_same<_UnaryPred, EqualTo<ValueType>>::value) {
+			return beg + simdFindEqual(beg, end - beg, pred.m_value);
+		}
+		else if constexpr (std::is_same<_UnaryPred, InRange<ValueType>>::value) {
+			return beg + simdFindInRange(beg, end - beg, pred.m_low, pred.m_high);
+		}
+	}
 	while (beg != end) {
 		if (pred(*beg)) {
 			return beg;
@@ -17,6 +39,12 @@ _ForwardIter minElement(_ForwardIter beg, _ForwardIter end) {
 	if (beg == end) {
 		return end;
 	}
+	if constexpr (IsSimdRange<_ForwardIter>::value) {
+		typename std::remove_cv<typename std::remove_pointer<_ForwardIter>::type>::type smallest, largest;
+		if (simdMinMax(beg, end - beg, smallest, largest)) {
+			return beg + simdFindEqual(beg, end - beg, smallest);
+		}
+	}
 	_ForwardIter smallest = beg;
 	while (++beg != end) {
 		if (*beg < *smallest) {
@@ -31,6 +59,12 @@ _ForwardIter maxElement(_ForwardIter beg, _ForwardIter end) {
 	if (beg == end) {
 		return end;
 	}
+	if constexpr (IsSimdRange<_ForwardIter>::value) {
+		typename std::remove_cv<typename std::remove_pointer<_ForwardIter>::type>::type smallest, largest;
+		if (simdMinMax(beg, end - beg, smallest, largest)) {
+			return beg + simdFindEqual(beg, end - beg, largest);
+		}
+	}
 	_ForwardIter largest = beg;
 	while (++beg != end) {
 		if (*beg > *largest) {
@@ -40,6 +74,33 @@ _ForwardIter maxElement(_ForwardIter beg, _ForwardIter end) {
 	return largest;
 }
 
+/*
+Минимум и максимум за один проход (из равных - первые, как у minElement и maxElement).
+Для указателей на double/float/int32_t/uint32_t значения ищутся векторно, а позиции - векторным поиском равного.
+*/
+template <class _ForwardIter>
+std::pair<_ForwardIter, _ForwardIter> minMaxElement(_ForwardIter beg, _ForwardIter end) {
+	if (beg == end) {
+		return { end, end };
+	}
+	if constexpr (IsSimdRange<_ForwardIter>::value) {
+		typename std::remove_cv<typename std::remove_pointer<_ForwardIter>::type>::type smallest, largest;
+		if (simdMinMax(beg, end - beg, smallest, largest)) {
+			return { beg + simdFindEqual(beg, end - beg, smallest), beg + simdFindEqual(beg, end - beg, largest) };
+		}
+	}
+	_ForwardIter smallest = beg, largest = beg;
+	while (++beg != end) {
+		if (*beg < *smallest) {
+			smallest = beg;
+		}
+		else if (*beg > *largest) {
+			largest = beg;
+		}
+	}
+	return { smallest, largest };
+}
+
 template<class _InputIter, class _Func>
 void forEach(_InputIter beg, _InputIter end, _Func op) {
 	while (beg != end) {
@@ -48,21 +109,434 @@ void forEach(_InputIter beg, _InputIter end, _Func op) {
 	}
 }
 
-template <class _BidirectionalIter>
-void sort(_BidirectionalIter beg, _BidirectionalIter end) {
-	if (end <= beg) {
+/*
+Сортировка (introsort в духе pdqsort): опорный элемент - медиана трех или медиана медиан трех троек (ninther)
+на больших диапазонах, сортировка вставками на коротких участках и пирамидальная сортировка, если глубина рекурсии
+превысила 2*log2(n). Худший случай - O(n log n). Повторы обрабатываются трехчастным разбиением: если опорный элемент
+равен элементу слева от диапазона (значит, меньших его в диапазоне нет), все равные ему отделяются одним проходом
+и больше не рассматриваются, так что k различных значений сортируются за O(n log k).
+Рекурсия идет только в меньшую часть, поэтому глубина стека - O(log n).
+*/
+const int kInsertionSortCutoff = 24;
+const int kNintherThreshold = 128;
+
+template <class _RandomIter, class _Compare>
+void insertionSort(_RandomIter beg, _RandomIter end, _Compare comp) {
+	if (beg == end) {
+		return;
+	}
+	for (_RandomIter i = beg + 1; i != end; ++i) {
+		if (comp(*i, *(i - 1))) {
+			auto value = std::move(*i);
+			_RandomIter j = i;
+			do {
+				*j = std::move(*(j - 1));
+				--j;
+			} while (j != beg && comp(value, *(j - 1)));
+			*j = std::move(value);
+		}
+	}
+}
+
+template <class _RandomIter, class _Compare>
+void siftDown(_RandomIter beg, ptrdiff_t root, ptrdiff_t size, _Compare comp) {
+	while (2 * root + 1 < size) {
+		ptrdiff_t child = 2 * root + 1;
+		if (child + 1 < size && comp(beg[child], beg[child + 1])) {
+			child++;
+		}
+		if (!comp(beg[root], beg[child])) {
+			return;
+		}
+		std::iter_swap(beg + root, beg + child);
+		root = child;
+	}
+}
+
+template <class _RandomIter, class _Compare>
+void heapSort(_RandomIter beg, _RandomIter end, _Compare comp) {
+	ptrdiff_t size = end - beg;
+	for (ptrdiff_t i = size / 2 - 1; i >= 0; i--) {
+		siftDown(beg, i, size, comp);
+	}
+	for (ptrdiff_t i = size - 1; i > 0; i--) {
+		std::iter_swap(beg, beg + i);
+		siftDown(beg, 0, i, comp);
+	}
+}
+
+// Упорядочивает *a, *b, *c так, что медиана оказывается в *b.
+template <class _RandomIter, class _Compare>
+void sort3(_RandomIter a, _RandomIter b, _RandomIter c, _Compare comp) {
+	if (comp(*b, *a)) {
+		std::iter_swap(a, b);
+	}
+	if (comp(*c, *b)) {
+		std::iter_swap(b, c);
+		if (comp(*b, *a)) {
+			std::iter_swap(a, b);
+		}
+	}
+}
+
+/*
+Разбиение Хоара относительно опорного *beg: возвращает итоговую позицию опорного элемента,
+левее нее - не большие, правее - не меньшие. При equal_left все элементы, не большие опорного, уходят влево.
+*/
+template <class _RandomIter, class _Compare>
+_RandomIter partitionAt(_RandomIter beg, _RandomIter end, bool equal_left, _Compare comp) {
+	_RandomIter first = beg + 1, last = end - 1;
+	while (true) {
+		if (equal_left) {
+			while (first <= last && !comp(*beg, *first)) {
+				++first;
+			}
+		}
+		else {
+			while (first <= last && comp(*first, *beg)) {
+				++first;
+			}
+		}
+		while (first <= last && comp(*beg, *last)) {
+			--last;
+		}
+		if (first >= last) {
+			break;
+		}
+		std::iter_swap(first, last);
+		++first;
+		--last;
+	}
+	std::iter_swap(beg, last);
+	return last;
+}
+
+// leftmost - левее диапазона нет элементов; иначе *(beg - 1) не больше любого элемента диапазона.
+template <class _RandomIter, class _Compare>
+void introSort(_RandomIter beg, _RandomIter end, int depth_limit, bool leftmost, _Compare comp) {
+	while (end - beg > kInsertionSortCutoff) {
+		if (depth_limit-- == 0) {
+			heapSort(beg, end, comp);
+			return;
+		}
+		ptrdiff_t size = end - beg;
+		_RandomIter middle = beg + size / 2;
+		if (size > kNintherThreshold) {
+			ptrdiff_t step = size / 8;
+			sort3(beg, beg + step, beg + 2 * step, comp);
+			sort3(middle - step, middle, middle + step, comp);
+			sort3(end - 1 - 2 * step, end - 1 - step, end - 1, comp);
+			sort3(beg + step, middle, end - 1 - step, comp);
+		}
+		else {
+			sort3(beg, middle, end - 1, comp);
+		}
+		std::iter_swap(beg, middle);
+
+		if (!leftmost && !comp(*(beg - 1), *beg)) {
+			beg = partitionAt(beg, end, true, comp) + 1;     // [beg, позиция опорного] - равные опорному
+			continue;
+		}
+		_RandomIter pivot = partitionAt(beg, end, false, comp);
+		if (pivot - beg < end - pivot) {
+			introSort(beg, pivot, depth_limit, leftmost, comp);
+			beg = pivot + 1;
+			leftmost = false;
+		}
+		else {
+			introSort(pivot + 1, end, depth_limit, false, comp);
+			end = pivot;
+		}
+	}
+	insertionSort(beg, end, comp);
+}
+
+template <class _RandomIter, class _Compare>
+void sort(_RandomIter beg, _RandomIter end, _Compare comp) {
+	if (end - beg < 2) {
+		return;
+	}
+	int depth_limit = 0;
+	for (ptrdiff_t size = end - beg; size > 1; size /= 2) {
+		depth_limit += 2;
+	}
+	introSort(beg, end, depth_limit, true, comp);
+}
+
+template <class _RandomIter>
+void sort(_RandomIter beg, _RandomIter end) {
+	::sort(beg, end, std::less<>());     // квалифицированный вызов: иначе поиск по аргументам находит и std::sort
+}
+
+/*
+Устойчивая сортировка (равные элементы сохраняют взаимный порядок): вставками сортируются отрезки
+по kInsertionSortCutoff элементов, затем отрезки сливаются снизу вверх через буфер размера n. O(n log n).
+*/
+template <class _RandomIter, class _Compare>
+void stableSort(_RandomIter beg, _RandomIter end, _Compare comp) {
+	using ValueType = typename std::iterator_traits<_RandomIter>::value_type;
+	ptrdiff_t size = end - beg;
+	if (size < 2) {
+		return;
+	}
+	for (ptrdiff_t i = 0; i < size; i += kInsertionSortCutoff) {
+		insertionSort(beg + i, beg + std::min<ptrdiff_t>(i + kInsertionSortCutoff, size), comp);
+	}
+	std::vector<ValueType> buffer;
+	buffer.reserve(size);
+	for (ptrdiff_t width = kInsertionSortCutoff; width < size; width *= 2) {
+		for (ptrdiff_t left = 0; left + width < size; left += 2 * width) {
+			_RandomIter middle = beg + left + width;
+			_RandomIter right_end = beg + std::min<ptrdiff_t>(left + 2 * width, size);
+			if (!comp(*middle, *(middle - 1))) {
+				continue;     // части уже идут по порядку
+			}
+			buffer.clear();
+			std::move(beg + left, middle, std::back_inserter(buffer));
+			auto first = buffer.begin();
+			_RandomIter second = middle, dest = beg + left;
+			while (first != buffer.end() && second != right_end) {
+				if (comp(*second, *first)) {
+					*dest = std::move(*second);
+					++second;
+				}
+				else {
+					*dest = std::move(*first);
+					++first;
+				}
+				++dest;
+			}
+			std::move(first, buffer.end(), dest);
+		}
+	}
+}
+
+template <class _RandomIter>
+void stableSort(_RandomIter beg, _RandomIter end) {
+	stableSort(beg, end, std::less<>());
+}
+
+/*
+Ключ сортировки, отображенный в беззнаковое целое с тем же порядком: у знаковых целых инвертируется знаковый бит,
+у чисел с плавающей точкой (IEEE-754) - знаковый бит у неотрицательных и все биты у отрицательных.
+*/
+template <class _Key>
+auto radixBits(_Key key) {
+	static_assert(std::is_integral<_Key>::value && !std::is_same<_Key, bool>::value, "radixSort requires an integral or floating point key");
+	using Bits = typename std::make_unsigned<_Key>::type;
+	Bits bits = static_cast<Bits>(key);
+	if constexpr (std::is_signed<_Key>::value) {
+		bits ^= static_cast<Bits>(Bits(1) << (sizeof(Bits) * 8 - 1));
+	}
+	return bits;
+}
+
+inline uint64_t radixBits(double key) {
+	uint64_t bits;
+	std::memcpy(&bits, &key, sizeof(bits));
+	return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+inline uint32_t radixBits(float key) {
+	uint32_t bits;
+	std::memcpy(&bits, &key, sizeof(bits));
+	return (bits >> 31) ? ~bits : bits | (uint32_t(1) << 31);
+}
+
+// Проходы LSD-сортировки по 8 бит: гистограммы всех разрядов считаются за один проход, разряды, одинаковые у всех ключей, пропускаются.
+template <class _Item, class _KeyOf>
+void radixPasses(std::vector<_Item>& items, std::vector<_Item>& temp, _KeyOf key_of) {
+	using Bits = decltype(key_of(items[0]));
+	const int kDigits = sizeof(Bits);
+	size_t size = items.size();
+	std::vector<size_t> counts(kDigits * 256, 0);
+	for (size_t i = 0; i < size; i++) {
+		Bits key = key_of(items[i]);
+		for (int digit = 0; digit < kDigits; digit++) {
+			counts[digit * 256 + ((key >> (digit * 8)) & 0xFF)]++;
+		}
+	}
+	for (int digit = 0; digit < kDigits; digit++) {
+		size_t* offsets = counts.data() + digit * 256;
+		if (offsets[(key_of(items[0]) >> (digit * 8)) & 0xFF] == size) {
+			continue;
+		}
+		size_t sum = 0;
+		for (int i = 0; i < 256; i++) {
+			size_t count = offsets[i];
+			offsets[i] = sum;
+			sum += count;
+		}
+		for (size_t i = 0; i < size; i++) {
+			temp[offsets[(key_of(items[i]) >> (digit * 8)) & 0xFF]++] = items[i];
+		}
+		items.swap(temp);
+	}
+}
+
+/*
+Устойчивая поразрядная сортировка (LSD) по ключу proj(элемент) целого или вещественного типа.
+Небольшие тривиально копируемые элементы переставляются сами, а ключ пересчитывается на каждом проходе;
+остальные сортируются как пары (ключ, номер элемента) и перемещаются один раз в конце.
+*/
+template <class _RandomIter, class _Proj>
+void radixSort(_RandomIter beg, _RandomIter end, _Proj proj) {
+	using ValueType = typename std::iterator_traits<_RandomIter>::value_type;
+	using Bits = decltype(radixBits(proj(*beg)));
+	size_t size = end - beg;
+	if (size < 2) {
 		return;
 	}
-	_BidirectionalIter pivot = beg, middle = beg + 1;
-	for (_BidirectionalIter i = middle; i < end; ++i) {
-		if (*i < *pivot) {
-			std::iter_swap(i, middle);
-			++middle;
+	if constexpr (std::is_trivially_copyable<ValueType>::value && sizeof(ValueType) <= 2 * sizeof(Bits)) {
+		std::vector<ValueType> items(beg, end), temp(items);
+		radixPasses(items, temp, [&proj](const ValueType& value) {
+			return radixBits(proj(value));
+		});
+		std::copy(items.begin(), items.end(), beg);
+	}
+	else {
+		struct Item {
+			Bits m_key;
+			size_t m_index;
+		};
+		std::vector<Item> items(size), temp(size);
+		for (size_t i = 0; i < size; i++) {
+			items[i].m_key = radixBits(proj(beg[i]));
+			items[i].m_index = i;
+		}
+		radixPasses(items, temp, [](const Item& item) {
+			return item.m_key;
+		});
+		std::vector<ValueType> sorted;
+		sorted.reserve(size);
+		for (size_t i = 0; i < size; i++) {
+			sorted.push_back(std::move(beg[items[i].m_index]));
+		}
+		std::move(sorted.begin(), sorted.end(), beg);
+	}
+}
+
+template <class _RandomIter>
+void radixSort(_RandomIter beg, _RandomIter end) {
+	radixSort(beg, end, [](const auto& value) { return value; });
+}
+
+// Слияние [a, a_end) и [b, b_end) в dest перемещением; при равенстве первым идет элемент из a.
+template <class _SrcIter, class _DestIter, class _Compare>
+void mergeMove(_SrcIter a, _SrcIter a_end, _SrcIter b, _SrcIter b_end, _DestIter dest, _Compare comp) {
+	while (a != a_end && b != b_end) {
+		if (comp(*b, *a)) {
+			*dest = std::move(*b);
+			++b;
+		}
+		else {
+			*dest = std::move(*a);
+			++a;
 		}
+		++dest;
 	}
-	std::iter_swap(beg, middle - 1);
-	sort(beg, middle - 1);
-	sort(middle, end);
+	dest = std::move(a, a_end, dest);
+	std::move(b, b_end, dest);
+}
+
+// Сколько элементов из a (длины a_size) попадает в первые k элементов слияния a и b (длины b_size).
+template <class _SrcIter, class _Compare>
+size_t mergeSplit(_SrcIter a, size_t a_size, _SrcIter b, size_t b_size, size_t k, _Compare comp) {
+	size_t low = k > b_size ? k - b_size : 0;
+	size_t high = k < a_size ? k : a_size;
+	while (low < high) {
+		size_t i = (low + high) / 2;
+		if (!comp(b[k - i - 1], a[i])) {
+			low = i + 1;
+		}
+		else {
+			high = i;
+		}
+	}
+	return low;
+}
+
+/*
+Один уровень слияния соседних пар отрезков (bounds - границы отрезков) из src в dest. Каждое слияние пары
+делится по позициям результата на несколько независимых кусков, чтобы на последних уровнях, где пар меньше,
+чем потоков, работали все потоки.
+*/
+template <class _SrcIter, class _DestIter, class _Compare>
+void mergeLevel(int threads, _SrcIter src, _DestIter dest, const std::vector<size_t>& bounds, _Compare comp) {
+	struct Task {
+		size_t m_a, m_a_end, m_b, m_b_end, m_out;
+	};
+	int pairs = static_cast<int>(bounds.size() - 1) / 2;
+	int pieces = threads > pairs ? threads / pairs : 1;
+	std::vector<Task> tasks;
+	for (int pair = 0; pair < pairs; pair++) {
+		size_t left = bounds[2 * pair], middle = bounds[2 * pair + 1], right = bounds[2 * pair + 2];
+		size_t total = right - left;
+		size_t prev_i = 0, prev_k = 0;
+		for (int piece = 1; piece <= pieces; piece++) {
+			size_t k = total * piece / pieces;
+			size_t i = mergeSplit(src + left, middle - left, src + middle, right - middle, k, comp);
+			tasks.push_back({ left + prev_i, left + i, middle + (prev_k - prev_i), middle + (k - i), left + prev_k });
+			prev_i = i;
+			prev_k = k;
+		}
+	}
+	int workers = threads < static_cast<int>(tasks.size()) ? threads : static_cast<int>(tasks.size());
+	parallelRun(workers, [&](int worker) {
+		for (size_t i = worker; i < tasks.size(); i += workers) {
+			const Task& task = tasks[i];
+			mergeMove(src + task.m_a, src + task.m_a_end, src + task.m_b, src + task.m_b_end, dest + task.m_out, comp);
+		}
+	});
+}
+
+/*
+Параллельная (неустойчивая) сортировка: диапазон делится на 2^k частей, части сортируются введенной выше sort
+в нескольких потоках, затем за k уровней попарно сливаются через буфер. k выбирается нечетным, чтобы после
+переноса элементов в буфер последний уровень слияния записывал результат обратно в исходный диапазон.
+*/
+template <class _RandomIter, class _Compare>
+void parallelSort(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end, _Compare comp) {
+	using ValueType = typename std::iterator_traits<_RandomIter>::value_type;
+	size_t size = end - beg;
+	int threads = policy.PartsFor(size);
+	if (threads == 1) {
+		::sort(beg, end, comp);
+		return;
+	}
+	int levels = 1;
+	while ((1 << levels) < threads) {
+		levels += 2;
+	}
+	int parts = 1 << levels;
+	std::vector<ValueType> buffer(std::make_move_iterator(beg), std::make_move_iterator(end));
+	std::vector<size_t> bounds(parts + 1);
+	for (int i = 0; i <= parts; i++) {
+		bounds[i] = partOffset(size, i, parts);
+	}
+	parallelRun(threads, [&](int worker) {
+		for (int part = worker; part < parts; part += threads) {
+			::sort(buffer.begin() + bounds[part], buffer.begin() + bounds[part + 1], comp);
+		}
+	});
+	for (int level = 0; level < levels; level++) {
+		if (level % 2 == 0) {
+			mergeLevel(threads, buffer.begin(), beg, bounds, comp);
+		}
+		else {
+			mergeLevel(threads, beg, buffer.begin(), bounds, comp);
+		}
+		std::vector<size_t> merged;
+		for (size_t i = 0; i < bounds.size(); i += 2) {
+			merged.push_back(bounds[i]);
+		}
+		bounds.swap(merged);
+	}
+}
+
+template <class _RandomIter>
+void parallelSort(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end) {
+	parallelSort(policy, beg, end, std::less<>());
 }
 
 template <class _InputIter, class _OutputIter, class _UnaryPred>
@@ -76,3 +550,235 @@ _OutputIter copyIf(_InputIter source_beg, _InputIter source_end, _OutputIter des
 	}
 	return dest_beg;
 }
+
+
+
+// Итератор допускает прыжки на произвольное расстояние (диапазон можно делить на части без обхода).
+template<typename _Iter, typename = void>
+struct IsRandomAccessIterator : std::false_type {};
+
+template<typename _Iter>
+struct IsRandomAccessIterator<_Iter, std::void_t<typename std::iterator_traits<_Iter>::iterator_category>>
+	: std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<_Iter>::iterator_category> {};
+
+
+/*
+Параллельные перегрузки. Первый аргумент - ParallelPolicy. Диапазон [beg, end) должен задаваться итераторами
+произвольного доступа и делится на равные части. Контейнер с методом Split (UnorderedMap) передается целиком
+и делится на диапазоны корзин без обхода списка. Функции и предикаты вызываются из нескольких потоков одновременно.
+Результаты findIf/minElement/maxElement совпадают с последовательными версиями (для контейнера - в порядке частей).
+*/
+
+template<class _RandomIter, class _Func>
+void forEach(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end, _Func op) {
+	static_assert(IsRandomAccessIterator<_RandomIter>::value, "parallel forEach requires random access iterators");
+	size_t count = end - beg;
+	int parts = policy.PartsFor(count);
+	parallelRun(parts, [&](int part) {
+		forEach(beg + partOffset(count, part, parts), beg + partOffset(count, part + 1, parts), op);
+	});
+}
+
+template<class _Splittable, class _Func>
+void forEach(const ParallelPolicy& policy, _Splittable& cont, _Func op) {
+	auto ranges = cont.Split(policy.PartsFor(cont.Size()));
+	parallelRun(static_cast<int>(ranges.size()), [&](int part) {
+		forEach(ranges[part].begin(), ranges[part].end(), op);
+	});
+}
+
+// Части просматриваются по порядку; часть прекращает поиск, как только найден элемент левее ее текущей позиции.
+template<typename _RandomIter, typename _UnaryPred>
+_RandomIter findIf(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end, _UnaryPred pred) {
+	static_assert(IsRandomAccessIterator<_RandomIter>::value, "parallel findIf requires random access iterators");
+	size_t count = end - beg;
+	int parts = policy.PartsFor(count);
+	std::atomic<size_t> found(count);
+	parallelRun(parts, [&](int part) {
+		size_t last = partOffset(count, part + 1, parts);
+		for (size_t i = partOffset(count, part, parts); i < last && i < found.load(std::memory_order_relaxed); i++) {
+			if (pred(beg[i])) {
+				size_t current = found.load(std::memory_order_relaxed);
+				while (i < current && !found.compare_exchange_weak(current, i, std::memory_order_relaxed)) {}
+				return;
+			}
+		}
+	});
+	return beg + found.load();
+}
+
+template<typename _Splittable, typename _UnaryPred>
+typename _Splittable::iterator findIf(const ParallelPolicy& policy, _Splittable& cont, _UnaryPred pred) {
+	auto ranges = cont.Split(policy.PartsFor(cont.Size()));
+	int parts = static_cast<int>(ranges.size());
+	std::vector<typename _Splittable::iterator> results(parts, cont.end());
+	std::atomic<int> found(parts);
+	parallelRun(parts, [&](int part) {
+		for (auto iter = ranges[part].begin(); iter != ranges[part].end() && part < found.load(std::memory_order_relaxed); ++iter) {
+			if (pred(*iter)) {
+				results[part] = iter;
+				int current = found.load(std::memory_order_relaxed);
+				while (part < current && !found.compare_exchange_weak(current, part, std::memory_order_relaxed)) {}
+				return;
+			}
+		}
+	});
+	int part = found.load();
+	return part < parts ? results[part] : cont.end();
+}
+
+// Минимумы частей сводятся по порядку частей, поэтому из равных выбирается первый, как и в последовательной версии.
+template <class _RandomIter>
+_RandomIter minElement(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end) {
+	static_assert(IsRandomAccessIterator<_RandomIter>::value, "parallel minElement requires random access iterators");
+	if (beg == end) {
+		return end;
+	}
+	size_t count = end - beg;
+	int parts = policy.PartsFor(count);
+	std::vector<_RandomIter> results(parts, end);
+	parallelRun(parts, [&](int part) {
+		results[part] = minElement(beg + partOffset(count, part, parts), beg + partOffset(count, part + 1, parts));
+	});
+	_RandomIter smallest = results[0];
+	for (int i = 1; i < parts; i++) {
+		if (*results[i] < *smallest) {
+			smallest = results[i];
+		}
+	}
+	return smallest;
+}
+
+template <class _Splittable>
+typename _Splittable::iterator minElement(const ParallelPolicy& policy, _Splittable& cont) {
+	auto ranges = cont.Split(policy.PartsFor(cont.Size()));
+	int parts = static_cast<int>(ranges.size());
+	using RangeIter = decltype(ranges[0].begin());
+	std::vector<RangeIter> results(parts);
+	parallelRun(parts, [&](int part) {
+		results[part] = minElement(ranges[part].begin(), ranges[part].end());
+	});
+	typename _Splittable::iterator smallest = cont.end();
+	for (int i = 0; i < parts; i++) {
+		if (results[i] != ranges[i].end() && (smallest == cont.end() || *results[i] < *smallest)) {
+			smallest = results[i];
+		}
+	}
+	return smallest;
+}
+
+template <class _RandomIter>
+_RandomIter maxElement(const ParallelPolicy& policy, _RandomIter beg, _RandomIter end) {
+	static_assert(IsRandomAccessIterator<_RandomIter>::value, "parallel maxElement requires random access iterators");
+	if (beg == end) {
+		return end;
+	}
+	size_t count = end - beg;
+	int parts = policy.PartsFor(count);
+	std::vector<_RandomIter> results(parts, end);
+	parallelRun(parts, [&](int part) {
+		results[part] = maxElement(beg + partOffset(count, part, parts), beg + partOffset(count, part + 1, parts));
+	});
+	_RandomIter largest = results[0];
+	for (int i = 1; i < parts; i++) {
+		if (*results[i] > *largest) {
+			largest = results[i];
+		}
+	}
+	return largest;
+}
+
+template <class _Splittable>
+typename _Splittable::iterator maxElement(const ParallelPolicy& policy, _Splittable& cont) {
+	auto ranges = cont.Split(policy.PartsFor(cont.Size()));
+	int parts = static_cast<int>(ranges.size());
+	using RangeIter = decltype(ranges[0].begin());
+	std::vector<RangeIter> results(parts);
+	parallelRun(parts, [&](int part) {
+		results[part] = maxElement(ranges[part].begin(), ranges[part].end());
+	});
+	typename _Splittable::iterator largest = cont.end();
+	for (int i = 0; i < parts; i++) {
+		if (results[i] != ranges[i].end() && (largest == cont.end() || *results[i] > *largest)) {
+			largest = results[i];
+		}
+	}
+	return largest;
+}
+
+/*
+Общая часть параллельного copyIf: p_collect(part, matches) складывает в matches итераторы подходящих элементов части.
+CopyOrder::Preserve - элементы пишутся в порядке частей (в выходной итератор произвольного доступа - тоже параллельно),
+CopyOrder::Any - каждая часть пишет свои элементы под мьютексом сразу по готовности.
+*/
+template <class _Iter, class _OutputIter, class _Collect>
+_OutputIter copyParts(int parts, _Collect collect, _OutputIter dest_beg, CopyOrder order) {
+	std::vector<std::vector<_Iter>> matches(parts);
+	if (order == CopyOrder::Any) {
+		std::mutex dest_mutex;
+		parallelRun(parts, [&](int part) {
+			collect(part, matches[part]);
+			std::lock_guard<std::mutex> lock(dest_mutex);
+			for (auto& iter : matches[part]) {
+				*dest_beg = *iter;
+				++dest_beg;
+			}
+		});
+		return dest_beg;
+	}
+	parallelRun(parts, [&](int part) {
+		collect(part, matches[part]);
+	});
+	if constexpr (IsRandomAccessIterator<_OutputIter>::value) {
+		std::vector<size_t> offsets(parts + 1, 0);
+		for (int i = 0; i < parts; i++) {
+			offsets[i + 1] = offsets[i] + matches[i].size();
+		}
+		parallelRun(parts, [&](int part) {
+			_OutputIter dest = dest_beg + offsets[part];
+			for (auto& iter : matches[part]) {
+				*dest = *iter;
+				++dest;
+			}
+		});
+		return dest_beg + offsets[parts];
+	}
+	else {
+		for (auto& part_matches : matches) {
+			for (auto& iter : part_matches) {
+				*dest_beg = *iter;
+				++dest_beg;
+			}
+		}
+		return dest_beg;
+	}
+}
+
+template <class _RandomIter, class _OutputIter, class _UnaryPred>
+_OutputIter copyIf(const ParallelPolicy& policy, _RandomIter source_beg, _RandomIter source_end, _OutputIter dest_beg, _UnaryPred pred,
+	CopyOrder order = CopyOrder::Preserve) {
+	static_assert(IsRandomAccessIterator<_RandomIter>::value, "parallel copyIf requires random access iterators");
+	size_t count = source_end - source_beg;
+	int parts = policy.PartsFor(count);
+	return copyParts<_RandomIter>(parts, [&](int part, std::vector<_RandomIter>& matches) {
+		_RandomIter last = source_beg + partOffset(count, part + 1, parts);
+		for (_RandomIter iter = source_beg + partOffset(count, part, parts); iter != last; ++iter) {
+			if (pred(*iter)) {
+				matches.push_back(iter);
+			}
+		}
+	}, dest_beg, order);
+}
+
+template <class _Splittable, class _OutputIter, class _UnaryPred>
+_OutputIter copyIf(const ParallelPolicy& policy, _Splittable& cont, _OutputIter dest_beg, _UnaryPred pred, CopyOrder order = CopyOrder::Preserve) {
+	auto ranges = cont.Split(policy.PartsFor(cont.Size()));
+	using RangeIter = decltype(ranges[0].begin());
+	return copyParts<RangeIter>(static_cast<int>(ranges.size()), [&](int part, std::vector<RangeIter>& matches) {
+		for (auto iter = ranges[part].begin(); iter != ranges[part].end(); ++iter) {
+			if (pred(*iter)) {
+				matches.push_back(iter);
+			}
+		}
+	}, dest_beg, order);
+}
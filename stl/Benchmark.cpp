@@ -0,0 +1,339 @@
+#include "Algorithms.h"
+#include "Container.h"
+#include "Goods.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/*
+Head-to-head benchmarks of UnorderedMap and the algorithms against std::unordered_map and <algorithm>.
+Both sides of a case run on the same data; the best of several runs is reported in nanoseconds per element,
+so the numbers of different sizes are comparable. The result is one JSON document on stdout.
+
+Usage: stl_bench [--quick]      --quick uses small sizes and fewer runs (smoke check of the build)
+*/
+
+
+namespace {
+
+volatile uint64_t g_sink;       // keeps the measured work from being optimized away
+
+struct Options {
+	std::vector<size_t> m_sizes = { 1000, 100000, 1000000 };
+	int m_repeats = 5;
+};
+
+struct Result {
+	std::string m_case;
+	std::string m_types;
+	size_t m_size;
+	double m_stl_ns;
+	double m_std_ns;
+};
+
+
+// Small sizes are repeated more often so that every case runs for a measurable time.
+int repeatsFor(const Options& p_options, size_t p_size) {
+	size_t factor = p_size < 100000 ? 100000 / p_size : 1;
+	return p_options.m_repeats * static_cast<int>(factor < 100 ? factor : 100);
+}
+
+// Best of p_repeats runs, in nanoseconds per element. p_setup prepares the state of a run and is not timed.
+template<typename _Setup, typename _Run>
+double measure(int p_repeats, size_t p_elements, _Setup p_setup, _Run p_run) {
+	double best = 0;
+	for (int i = 0; i < p_repeats; i++) {
+		auto state = p_setup();
+		auto start = std::chrono::steady_clock::now();
+		p_run(state);
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		double ns = std::chrono::duration<double, std::nano>(elapsed).count() / p_elements;
+		if (i == 0 || ns < best) {
+			best = ns;
+		}
+	}
+	return best;
+}
+
+
+// Data sets. The first p_size keys are inserted, the next p_size are guaranteed misses.
+std::vector<uint32_t> makeKeys(size_t p_size, uint32_t) {
+	std::vector<uint32_t> keys(2 * p_size);
+	for (size_t i = 0; i < keys.size(); i++) {
+		keys[i] = static_cast<uint32_t>(i) * 2654435761u;     // multiplication by an odd constant is a bijection
+	}
+	return keys;
+}
+
+std::vector<std::string> makeKeys(size_t p_size, const std::string&) {
+	std::vector<std::string> keys;
+	keys.reserve(2 * p_size);
+	for (uint32_t key : makeKeys(p_size, uint32_t())) {
+		keys.push_back("goods/" + std::to_string(key));
+	}
+	return keys;
+}
+
+std::vector<uint32_t> makeValues(size_t p_size, uint32_t) {
+	std::vector<uint32_t> values(p_size);
+	for (size_t i = 0; i < p_size; i++) {
+		values[i] = static_cast<uint32_t>(i);
+	}
+	return values;
+}
+
+std::vector<Goods> makeValues(size_t p_size, const Goods&) {
+	static const char* names[] = { "cupboard", "shelf", "nightstand", "chair", "armchair", "table", "cup", "pen" };
+	static const char* manufacturers[] = { "IKEA", "MZ5 group", "RIVAL", "Sanflor", "Aquanet", "FixPrice" };
+	static const char* addresses[] = { "Moscow, Pushkin street, 7", "Saratov, Prospekt mira, 23", "Rostov, Sokolov Avenue, 1",
+		"Omsk, Lenin street, 31", "Tomsk, Andropov avenue, 8" };
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> weight(0.1, 30.0);
+	std::vector<Goods> values;
+	values.reserve(p_size);
+	for (size_t i = 0; i < p_size; i++) {
+		values.push_back({ static_cast<uint32_t>(i), names[random() % 8], manufacturers[random() % 6], addresses[random() % 5], weight(random) });
+	}
+	return values;
+}
+
+uint64_t digest(uint32_t p_key) {
+	return p_key;
+}
+
+uint64_t digest(const std::string& p_key) {
+	return p_key.size();
+}
+
+
+// The same operations under both interfaces.
+template<typename _Key, typename _Value>
+void mapInsert(UnorderedMap<_Key, _Value>& p_map, const _Key& p_key, const _Value& p_value) {
+	p_map.TryEmplace(p_key, p_value);
+}
+
+template<typename _Key, typename _Value>
+void mapInsert(std::unordered_map<_Key, _Value>& p_map, const _Key& p_key, const _Value& p_value) {
+	p_map.try_emplace(p_key, p_value);
+}
+
+template<typename _Key, typename _Value>
+bool mapContains(const UnorderedMap<_Key, _Value>& p_map, const _Key& p_key) {
+	return p_map.Find(p_key) != p_map.end();
+}
+
+template<typename _Key, typename _Value>
+bool mapContains(const std::unordered_map<_Key, _Value>& p_map, const _Key& p_key) {
+	return p_map.find(p_key) != p_map.end();
+}
+
+template<typename _Key, typename _Value>
+void mapErase(UnorderedMap<_Key, _Value>& p_map, const _Key& p_key) {
+	p_map.Erase(p_key);
+}
+
+template<typename _Key, typename _Value>
+void mapErase(std::unordered_map<_Key, _Value>& p_map, const _Key& p_key) {
+	p_map.erase(p_key);
+}
+
+template<typename _Key, typename _Value>
+size_t mapSize(const UnorderedMap<_Key, _Value>& p_map) {
+	return p_map.Size();
+}
+
+template<typename _Key, typename _Value>
+size_t mapSize(const std::unordered_map<_Key, _Value>& p_map) {
+	return p_map.size();
+}
+
+template<typename _Key, typename _Value>
+void mapReserve(UnorderedMap<_Key, _Value>& p_map, size_t p_size) {
+	p_map.Reserve(static_cast<int>(p_size));
+}
+
+template<typename _Key, typename _Value>
+void mapReserve(std::unordered_map<_Key, _Value>& p_map, size_t p_size) {
+	p_map.reserve(p_size);
+}
+
+
+// All map cases for one implementation; the times come in the order of kMapCases.
+const char* kMapCases[] = { "insert", "lookup_hit", "lookup_miss", "erase_churn", "iterate", "rehash", "copy" };
+
+template<typename _Map, typename _Key, typename _Value>
+std::vector<double> runMapCases(int p_repeats, const std::vector<_Key>& p_keys, const std::vector<_Value>& p_values) {
+	size_t size = p_values.size();
+	std::vector<_Key> lookups(p_keys.begin(), p_keys.begin() + size);
+	std::shuffle(lookups.begin(), lookups.end(), std::mt19937(7));
+	_Map filled;
+	for (size_t i = 0; i < size; i++) {
+		mapInsert(filled, p_keys[i], p_values[i]);
+	}
+	auto empty = [] { return _Map(); };
+	auto shared = [&filled] { return &filled; };
+	auto copy = [&filled] { return _Map(filled); };
+
+	std::vector<double> times;
+	times.push_back(measure(p_repeats, size, empty, [&](_Map& p_map) {
+		for (size_t i = 0; i < size; i++) {
+			mapInsert(p_map, p_keys[i], p_values[i]);
+		}
+	}));
+	times.push_back(measure(p_repeats, size, shared, [&](const _Map* p_map) {
+		uint64_t found = 0;
+		for (const _Key& key : lookups) {
+			found += mapContains(*p_map, key);
+		}
+		g_sink = found;
+	}));
+	times.push_back(measure(p_repeats, size, shared, [&](const _Map* p_map) {
+		uint64_t found = 0;
+		for (size_t i = size; i < 2 * size; i++) {
+			found += mapContains(*p_map, p_keys[i]);
+		}
+		g_sink = found;
+	}));
+	// Erase every element in random order and insert it back: the size stays the same, nodes are recycled.
+	times.push_back(measure(p_repeats, 2 * size, copy, [&](_Map& p_map) {
+		for (size_t i = 0; i < size; i++) {
+			mapErase(p_map, lookups[i]);
+			mapInsert(p_map, lookups[i], p_values[0]);
+		}
+	}));
+	times.push_back(measure(p_repeats, size, shared, [&](const _Map* p_map) {
+		uint64_t sum = 0;
+		for (const auto& pair : *p_map) {
+			sum += digest(pair.first);
+		}
+		g_sink = sum;
+	}));
+	times.push_back(measure(p_repeats, size, copy, [&](_Map& p_map) {
+		mapReserve(p_map, 4 * size);
+	}));
+	times.push_back(measure(p_repeats, size, shared, [&](const _Map* p_map) {
+		_Map clone(*p_map);
+		g_sink = mapSize(clone);
+	}));
+	return times;
+}
+
+template<typename _Key, typename _Value>
+void benchmarkMap(const Options& p_options, const std::string& p_types, std::vector<Result>& p_results) {
+	for (size_t size : p_options.m_sizes) {
+		std::vector<_Key> keys = makeKeys(size, _Key());
+		std::vector<_Value> values = makeValues(size, _Value());
+		int repeats = repeatsFor(p_options, size);
+		std::vector<double> stl_times = runMapCases<UnorderedMap<_Key, _Value>>(repeats, keys, values);
+		std::vector<double> std_times = runMapCases<std::unordered_map<_Key, _Value>>(repeats, keys, values);
+		for (size_t i = 0; i < stl_times.size(); i++) {
+			p_results.push_back({ kMapCases[i], p_types, size, stl_times[i], std_times[i] });
+		}
+	}
+}
+
+
+// Algorithms on vectors of random values; sorting starts from the same unsorted copy every run.
+template<typename _Type, typename _StlSort, typename _StdSort>
+void benchmarkSort(const Options& p_options, const std::string& p_types, const std::vector<_Type>& p_data,
+	_StlSort p_stl_sort, _StdSort p_std_sort, std::vector<Result>& p_results) {
+	int repeats = repeatsFor(p_options, p_data.size());
+	auto copy = [&p_data] { return p_data; };
+	double stl_ns = measure(repeats, p_data.size(), copy, p_stl_sort);
+	double std_ns = measure(repeats, p_data.size(), copy, p_std_sort);
+	p_results.push_back({ "sort", p_types, p_data.size(), stl_ns, std_ns });
+}
+
+void benchmarkAlgorithms(const Options& p_options, std::vector<Result>& p_results) {
+	for (size_t size : p_options.m_sizes) {
+		std::mt19937 random(11);
+		std::vector<uint32_t> integers(size);
+		std::vector<double> doubles(size);
+		for (size_t i = 0; i < size; i++) {
+			integers[i] = random() % 1000000000u;
+			doubles[i] = std::generate_canonical<double, 53>(random) * 1000.0;
+		}
+		std::vector<std::string> strings = makeKeys(size / 2 + 1, std::string());
+		strings.resize(size);
+		std::shuffle(strings.begin(), strings.end(), random);
+		std::vector<Goods> goods = makeValues(size, Goods());
+		auto by_weight = [](const Goods& p_lhs, const Goods& p_rhs) { return p_lhs.m_weight < p_rhs.m_weight; };
+
+		benchmarkSort(p_options, "uint32", integers,
+			[](std::vector<uint32_t>& p_data) { ::sort(p_data.begin(), p_data.end()); },
+			[](std::vector<uint32_t>& p_data) { std::sort(p_data.begin(), p_data.end()); }, p_results);
+		benchmarkSort(p_options, "double", doubles,
+			[](std::vector<double>& p_data) { ::sort(p_data.begin(), p_data.end()); },
+			[](std::vector<double>& p_data) { std::sort(p_data.begin(), p_data.end()); }, p_results);
+		benchmarkSort(p_options, "string", strings,
+			[](std::vector<std::string>& p_data) { ::sort(p_data.begin(), p_data.end()); },
+			[](std::vector<std::string>& p_data) { std::sort(p_data.begin(), p_data.end()); }, p_results);
+		benchmarkSort(p_options, "Goods", goods,
+			[&by_weight](std::vector<Goods>& p_data) { ::sort(p_data.begin(), p_data.end(), by_weight); },
+			[&by_weight](std::vector<Goods>& p_data) { std::sort(p_data.begin(), p_data.end(), by_weight); }, p_results);
+
+		// Scans look for a value that is absent, so the whole range is read.
+		int repeats = repeatsFor(p_options, size);
+		const double* first = doubles.data();
+		const double* last = first + size;
+		auto shared = [] { return 0; };
+		p_results.push_back({ "find_if", "double", size,
+			measure(repeats, size, shared, [&](int) { g_sink = findIf(first, last, [](double p_value) { return p_value < 0; }) - first; }),
+			measure(repeats, size, shared, [&](int) { g_sink = std::find_if(first, last, [](double p_value) { return p_value < 0; }) - first; }) });
+		p_results.push_back({ "find_equal", "double", size,
+			measure(repeats, size, shared, [&](int) { g_sink = findIf(first, last, EqualTo<double>{ -1.0 }) - first; }),
+			measure(repeats, size, shared, [&](int) { g_sink = std::find(first, last, -1.0) - first; }) });
+		p_results.push_back({ "min_element", "double", size,
+			measure(repeats, size, shared, [&](int) { g_sink = minElement(first, last) - first; }),
+			measure(repeats, size, shared, [&](int) { g_sink = std::min_element(first, last) - first; }) });
+		p_results.push_back({ "find_if", "Goods", size,
+			measure(repeats, size, shared, [&](int) {
+				g_sink = findIf(goods.begin(), goods.end(), [](const Goods& p_goods) { return p_goods.m_weight < 0; }) - goods.begin();
+			}),
+			measure(repeats, size, shared, [&](int) {
+				g_sink = std::find_if(goods.begin(), goods.end(), [](const Goods& p_goods) { return p_goods.m_weight < 0; }) - goods.begin();
+			}) });
+	}
+}
+
+
+void printJson(const Options& p_options, const std::vector<Result>& p_results) {
+	std::cout << "{\n  \"map_stats\": " << (STL_MAP_STATS ? "true" : "false") << ",\n  \"repeats\": " << p_options.m_repeats << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < p_results.size(); i++) {
+		const Result& result = p_results[i];
+		std::cout << "    {\"case\": \"" << result.m_case << "\", \"types\": \"" << result.m_types << "\", \"size\": " << result.m_size
+			<< ", \"stl_ns\": " << result.m_stl_ns << ", \"std_ns\": " << result.m_std_ns
+			<< ", \"ratio\": " << result.m_stl_ns / result.m_std_ns << "}" << (i + 1 < p_results.size() ? "," : "") << "\n";
+	}
+	std::cout << "  ]\n}\n";
+}
+
+}
+
+
+int main(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--quick") == 0) {
+			options.m_sizes = { 1000, 10000 };
+			options.m_repeats = 1;
+		}
+		else {
+			std::cerr << "usage: " << argv[0] << " [--quick]" << std::endl;
+			return 2;
+		}
+	}
+	std::vector<Result> results;
+	benchmarkMap<uint32_t, uint32_t>(options, "uint32->uint32", results);
+	benchmarkMap<std::string, uint32_t>(options, "string->uint32", results);
+	benchmarkMap<uint32_t, Goods>(options, "uint32->Goods", results);
+	benchmarkAlgorithms(options, results);
+	printJson(options, results);
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include "Container.h"
+#include "Hash.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+
+
+/*
+Потокобезопасный словарь: ключи по хэшу разбиты на независимые сегменты (шарды), каждый из которых -
+обычный UnorderedMap под собственной блокировкой читателей-писателей. Потоки, работающие с разными шардами,
+не мешают друг другу, а каждый шард растет (перехэшируется) сам по себе.
+Наружу не выдаются ни итераторы, ни ссылки на значения: все обращения к элементам идут под блокировкой шарда.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>>
+class ConcurrentUnorderedMap {
+private:
+	using PairType = std::pair<const _KeyType, _DataType>;
+	using MapType = UnorderedMap<_KeyType, _DataType, _Hash, _KeyEqual>;
+
+	// Каждый шард занимает отдельные кэш-линии, чтобы блокировки соседних шардов не делили линию.
+	struct alignas(64) Shard {
+		mutable std::shared_mutex m_mutex;
+		MapType m_map;
+	};
+
+	int m_shard_count;
+	std::unique_ptr<Shard[]> m_shards;
+	_Hash m_hash_obj;
+
+	/*
+	Шард выбирается по старшим битам перемешанного хэша: младшие биты использует политика корзин внутри шарда,
+	и при совпадении битов каждый шард заполнял бы лишь часть своих корзин.
+	*/
+	Shard& ShardFor(const _KeyType& p_key) const {
+		uint64_t hash = MixHash(static_cast<uint64_t>(m_hash_obj(p_key)));
+		return m_shards[static_cast<size_t>(hash >> 32) & static_cast<size_t>(m_shard_count - 1)];
+	}
+
+	static constexpr int kMaxShards = 1 << 16;
+
+	static int DefaultShardCount() {
+		unsigned threads = std::thread::hardware_concurrency();
+		return static_cast<int>(threads ? threads * 4 : 16);
+	}
+public:
+	// Число шардов (не больше kMaxShards) округляется вверх до степени двойки; 0 - по четыре шарда на аппаратный поток.
+	explicit ConcurrentUnorderedMap(int p_shards = 0) {
+		if (p_shards < 0 || p_shards > kMaxShards) {
+			throw InvalidValueError("InvalidValueError: invalid shard count.");
+		}
+		int wanted = p_shards ? p_shards : std::min(DefaultShardCount(), kMaxShards);
+		m_shard_count = 1;
+		while (m_shard_count < wanted) {
+			m_shard_count *= 2;
+		}
+		m_shards.reset(new Shard[m_shard_count]);
+	}
+
+	ConcurrentUnorderedMap(const ConcurrentUnorderedMap&) = delete;
+	ConcurrentUnorderedMap& operator=(const ConcurrentUnorderedMap&) = delete;
+
+	// Вставляет пару или заменяет значение существующего ключа; возвращает true, если ключ был новым.
+	bool Insert(const PairType& p_pair) {
+		Shard& shard = ShardFor(p_pair.first);
+		std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+		return shard.m_map.InsertOrAssign(p_pair.first, p_pair.second).second;
+	}
+
+	bool Insert(PairType&& p_pair) {
+		Shard& shard = ShardFor(p_pair.first);
+		std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+		return shard.m_map.InsertOrAssign(p_pair.first, std::move(p_pair.second)).second;
+	}
+
+	// Копия значения, если ключ есть.
+	std::optional<_DataType> Find(const _KeyType& p_key) const {
+		Shard& shard = ShardFor(p_key);
+		std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+		const _DataType* value = static_cast<const MapType&>(shard.m_map).TryGet(p_key);
+		if (!value) {
+			return std::nullopt;
+		}
+		return *value;
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		Shard& shard = ShardFor(p_key);
+		std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+		return shard.m_map.Contains(p_key);
+	}
+
+	// Возвращает true, если ключ был и удален.
+	bool Erase(const _KeyType& p_key) {
+		Shard& shard = ShardFor(p_key);
+		std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+		auto iter = shard.m_map.Find(p_key);
+		if (iter == shard.m_map.end()) {
+			return false;
+		}
+		shard.m_map.Erase(iter);
+		return true;
+	}
+
+	/*
+	Атомарно (относительно остальных операций с этим ключом) применяет p_func(_DataType&) к значению.
+	Возвращает false, если ключа нет. p_func выполняется под блокировкой шарда и не должен обращаться к контейнеру.
+	*/
+	template<typename _Func>
+	bool Update(const _KeyType& p_key, _Func p_func) {
+		Shard& shard = ShardFor(p_key);
+		std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+		_DataType* value = shard.m_map.TryGet(p_key);
+		if (!value) {
+			return false;
+		}
+		p_func(*value);
+		return true;
+	}
+
+	/*
+	Обходит все элементы, вызывая p_func(const PairType&). Каждый шард обходится целиком под своей блокировкой
+	чтения, поэтому внутри шарда видно согласованное состояние; разные шарды могут отражать разные моменты времени.
+	*/
+	template<typename _Func>
+	void ForEach(_Func p_func) const {
+		for (int i = 0; i < m_shard_count; i++) {
+			std::shared_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+			const MapType& map = m_shards[i].m_map;
+			for (auto iter = map.cbegin(); iter != map.cend(); ++iter) {
+				p_func(*iter);
+			}
+		}
+	}
+
+	int Size() const {
+		int size = 0;
+		for (int i = 0; i < m_shard_count; i++) {
+			std::shared_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+			size += m_shards[i].m_map.Size();
+		}
+		return size;
+	}
+
+	bool Empty() const {
+		return Size() == 0;
+	}
+
+	void Clear() {
+		for (int i = 0; i < m_shard_count; i++) {
+			std::unique_lock<std::shared_mutex> lock(m_shards[i].m_mutex);
+			m_shards[i].m_map.Clear();
+		}
+	}
+
+	int GetShardCount() const {
+		return m_shard_count;
+	}
+};
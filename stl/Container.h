@@ -1,77 +1,530 @@
 #pragma once
 #include "List.h"
 #include "Exceptions.h"
+#include "Hash.h"
 #include "Iterator.h"
+#include "Stats.h"
 #include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
 
 
-template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>>
+// Подсказка процессору заранее загрузить кэш-линию по адресу p_ptr (на корректность не влияет).
+inline void PrefetchRead(const void* p_ptr) {
+#if defined(_MSC_VER)
+	_mm_prefetch(static_cast<const char*>(p_ptr), _MM_HINT_T0);
+#else
+	__builtin_prefetch(p_ptr, 0, 3);
+#endif
+}
+
+
+// Итератор допускает повторный проход (а значит, длину диапазона можно узнать заранее).
+template<typename _Iter, typename = void>
+struct IsForwardIterator : std::false_type {};
+
+template<typename _Iter>
+struct IsForwardIterator<_Iter, std::void_t<typename std::iterator_traits<_Iter>::iterator_category>>
+	: std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<_Iter>::iterator_category> {};
+
+
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>,
+	typename _BucketPolicy = PowerOfTwoBucketPolicy>
 class UnorderedMap {
 private:
 	using PairType = std::pair<const _KeyType, _DataType>;
 	using ChainType = Chain<_KeyType, _DataType, _Hash>;
 	using NodeType = Node<_KeyType, _DataType>;
+
+	template<typename _Key>
+	using EnableIfTransparent = typename std::enable_if<IsTransparent<_Hash, _KeyEqual>::value && !std::is_same<_Key, _KeyType>::value>::type;
 public:
 	using iterator = UnorderedMapIterator<_KeyType, _DataType>;
+	using const_iterator = UnorderedMapIterator<_KeyType, _DataType, true>;
+	using bucket_range = UnorderedMapBucketRange<_KeyType, _DataType>;
 
 private:
 	int m_buckets;
 	double m_load_factor;
 	double m_max_load_factor;
+	double m_min_load_factor;     // 0 - массив корзин не сжимается
+	bool m_shrink_pending;        // после последнего изменения размера массива были удаления: только тогда вставка может его сжать
 	_Hash m_hash_obj;
-	NodeType** m_table;    //  ( m_buckets)      (       ChainType)
-	ChainType m_chains;    // ,    
-public:
-	UnorderedMap() : m_buckets(8), m_load_factor(0.), m_max_load_factor(1.) {
-		m_table = new NodeType * [m_buckets] {};
+	_KeyEqual m_key_equal;
+	_BucketPolicy m_policy;       // отображение хэша в индекс корзины для m_table
+	NodeType** m_table;    // массив (размера m_buckets) из указателей на начало цепочек (все цепочки лежат в одном списке класса ChainType)
+	ChainType m_chains;    // список, в котором лежат цепочки
+
+	/*
+	Маленький контейнер (не больше kSmallSize элементов) обходится без массива корзин в куче: у него одна корзина,
+	ячейка которой лежит в самом объекте, и поиск - линейный проход по списку со сравнением сохраненных хэшей.
+	Пустой контейнер и контейнер после перемещения из него ничего не выделяют. Узлы и при этом лежат в пуле,
+	поэтому адреса элементов, как и для большого контейнера, не меняются при перемещении.
+	*/
+	static constexpr int kSmallSize = 8;
+	NodeType* m_inline_bucket[1];
+
+	/*
+	Состояние постепенного перехэширования: пока m_old_table != nullptr, часть цепочек еще висит на старом массиве,
+	а корзины [0, m_rehash_pos) уже перенесены. Номер корзины в узле хранится как 2 * индекс + четность массива,
+	поэтому соседние цепочки старого и нового массивов с одинаковым индексом не сливаются.
+	*/
+	static constexpr int kRehashStep = 4;
+	NodeType** m_old_table;
+	_BucketPolicy m_old_policy;
+	int m_old_buckets;
+	int m_rehash_pos;
+	int m_parity;
+	bool m_incremental_rehash;
+
+	STL_MAP_STAT(mutable MapCounters m_stats;)
+
+	// Массив корзин берется у того же memory_resource, что и узлы; массив из одной корзины - встроенный.
+	NodeType** NewTable(int p_buckets) {
+		if (p_buckets == 1) {
+			m_inline_bucket[0] = nullptr;
+			return m_inline_bucket;
+		}
+		NodeType** table = static_cast<NodeType**>(m_chains.GetResource()->allocate(sizeof(NodeType*) * p_buckets, alignof(NodeType*)));
+		for (int i = 0; i < p_buckets; i++) {
+			table[i] = nullptr;
+		}
+		return table;
 	}
 
-	explicit UnorderedMap(int p_buckets) : m_load_factor(0.), m_max_load_factor(1.) {
-		if (p_buckets < 8) {
-			m_buckets = 8;
+	void DeleteTable(NodeType** p_table, int p_buckets) {
+		if (p_table == m_inline_bucket) {
+			return;
+		}
+		m_chains.GetResource()->deallocate(p_table, sizeof(NodeType*) * p_buckets, alignof(NodeType*));
+	}
+
+	int BucketId(int p_index) const {
+		return 2 * p_index + m_parity;
+	}
+
+	int OldBucketId(int p_index) const {
+		return 2 * p_index + 1 - m_parity;
+	}
+
+	NodeType*& BucketHead(int p_bucket_id) {
+		if (p_bucket_id % 2 == m_parity) {
+			return m_table[p_bucket_id / 2];
+		}
+		return m_old_table[p_bucket_id / 2];
+	}
+
+	// Поиск в одной цепочке; при STL_MAP_STATS число просмотренных узлов прибавляется к p_probes.
+	template<typename _Key>
+	NodeType* FindInChain(NodeType* p_head, const _Key& p_key, size_t p_hash, int p_bucket_id, int& p_probes) const {
+#if STL_MAP_STATS
+		return m_chains.Find(p_head, p_key, p_hash, p_bucket_id, m_key_equal, p_probes);
+#else
+		(void)p_probes;
+		return m_chains.Find(p_head, p_key, p_hash, p_bucket_id, m_key_equal);
+#endif
+	}
+
+	template<typename _Key>
+	NodeType* FindNode(const _Key& p_key, size_t p_hash, int& p_probes) const {
+		int bucket_number = m_policy.Index(p_hash);
+		NodeType* node = FindInChain(m_table[bucket_number], p_key, p_hash, BucketId(bucket_number), p_probes);
+		if (!node && m_old_table) {
+			int old_bucket_number = m_old_policy.Index(p_hash);
+			node = FindInChain(m_old_table[old_bucket_number], p_key, p_hash, OldBucketId(old_bucket_number), p_probes);
+		}
+		return node;
+	}
+
+	template<typename _Key>
+	NodeType* FindNode(const _Key& p_key, size_t p_hash) const {
+		int probes = 0;
+		return FindNode(p_key, p_hash, probes);
+	}
+
+	// Поиск по запросу пользователя (Find, At, TryGet, Contains, Count); в статистику поисков попадают только такие.
+	template<typename _Key>
+	NodeType* LookupNode(const _Key& p_key) const {
+		int probes = 0;
+		NodeType* node = FindNode(p_key, m_hash_obj(p_key), probes);
+		STL_MAP_STAT(m_stats.RecordLookup(probes, node != nullptr);)
+		return node;
+	}
+
+	static constexpr int kBatchSize = 32;
+	static constexpr int kLookupBatchSize = 16;
+
+	template<typename... _Args>
+	NodeType* EmplaceNode(size_t p_hash, _Args&&... p_args) {
+		int bucket_number = m_policy.Index(p_hash);
+		STL_MAP_STAT(m_stats.RecordInsert();)
+		return m_chains.Emplace(p_hash, m_table[bucket_number], BucketId(bucket_number), std::forward<_Args>(p_args)...);
+	}
+
+	template<typename _Key, typename... _Args>
+	std::pair<iterator, bool> TryEmplaceImpl(_Key&& p_key, _Args&&... p_args) {
+		GrowIfNeeded();
+		size_t hash = m_hash_obj(p_key);
+		NodeType* node = FindNode(p_key, hash);
+		if (node) {
+			return { iterator(node), false };
+		}
+		node = EmplaceNode(hash, std::piecewise_construct, std::forward_as_tuple(std::forward<_Key>(p_key)),
+			std::forward_as_tuple(std::forward<_Args>(p_args)...));
+		return { iterator(node), true };
+	}
+
+	template<typename _Key, typename _Value>
+	std::pair<iterator, bool> InsertOrAssignImpl(_Key&& p_key, _Value&& p_value) {
+		GrowIfNeeded();
+		size_t hash = m_hash_obj(p_key);
+		NodeType* node = FindNode(p_key, hash);
+		if (node) {
+			node->m_pair.second = std::forward<_Value>(p_value);
+			return { iterator(node), false };
+		}
+		node = EmplaceNode(hash, std::forward<_Key>(p_key), std::forward<_Value>(p_value));
+		return { iterator(node), true };
+	}
+
+	template<typename _Pair>
+	void InsertHashed(_Pair&& p_pair, size_t p_hash) {
+		GrowIfNeeded();
+		NodeType* node = FindNode(p_pair.first, p_hash);
+		if (node) {
+			node->m_pair.second = std::forward<_Pair>(p_pair).second;
 		}
 		else {
-			m_buckets = p_buckets;
+			EmplaceNode(p_hash, std::forward<_Pair>(p_pair));
 		}
-		m_table = new NodeType * [m_buckets] {};
 	}
 
-	template<typename _Iter = iterator>
-	UnorderedMap(const _Iter& p_left, const _Iter& p_right) : UnorderedMap() {
-		for (auto cur = p_left; cur != p_right; cur++) {
-			Insert(*cur);
+	// Один раз готовит массив корзин и пул узлов под p_count новых элементов, чтобы вставки не вызывали перехэширований.
+	void PrepareBulkInsert(int p_count) {
+		int needed = Size() + p_count;
+		m_shrink_pending = false;
+		if (Overloaded(needed)) {
+			Rehash(BucketsFor(needed));
+		}
+		m_chains.ReserveNodes(p_count);
+	}
+
+	/*
+	Пакетный поиск: для пачки ключей сначала считаются хэши и запрашиваются ячейки массива корзин,
+	затем запрашиваются первые узлы цепочек, и только потом идут сравнения. Так промахи кэша по разным
+	ключам перекрываются, а не выстраиваются в очередь. Для каждого ключа по порядку вызывается p_sink(узел или nullptr).
+	*/
+	template<typename _KeyIter, typename _Sink>
+	void FindBatched(_KeyIter p_first, _KeyIter p_last, _Sink p_sink) const {
+		using KeyRef = decltype(*p_first);
+		using Key = typename std::remove_reference<KeyRef>::type;
+		Key* keys[kLookupBatchSize];
+		size_t hashes[kLookupBatchSize];
+		int buckets[kLookupBatchSize];
+		while (p_first != p_last) {
+			int count = 0;
+			for (; count < kLookupBatchSize && p_first != p_last; count++, ++p_first) {
+				keys[count] = &*p_first;
+				hashes[count] = m_hash_obj(*keys[count]);
+				buckets[count] = m_policy.Index(hashes[count]);
+				PrefetchRead(m_table + buckets[count]);
+			}
+			for (int i = 0; i < count; i++) {
+				if (m_table[buckets[i]]) {
+					PrefetchRead(m_table[buckets[i]]);
+				}
+			}
+			for (int i = 0; i < count; i++) {
+				int probes = 0;
+				NodeType* node = FindInChain(m_table[buckets[i]], *keys[i], hashes[i], BucketId(buckets[i]), probes);
+				if (!node && m_old_table) {
+					int old_bucket_number = m_old_policy.Index(hashes[i]);
+					node = FindInChain(m_old_table[old_bucket_number], *keys[i], hashes[i], OldBucketId(old_bucket_number), probes);
+				}
+				STL_MAP_STAT(m_stats.RecordLookup(probes, node != nullptr);)
+				p_sink(node);
+			}
+		}
+	}
+
+	int BucketsFor(int p_num) const {
+		return _BucketPolicy::RoundBuckets(static_cast<int>(p_num * 2 / m_max_load_factor));
+	}
+
+	// Наименьший массив корзин в куче: при сжатии меньше него бывает только встроенная корзина.
+	static int MinBuckets() {
+		return _BucketPolicy::RoundBuckets(8);
+	}
+
+	int ShrunkBuckets(int p_num) const {
+		if (p_num <= kSmallSize) {
+			return 1;
+		}
+		int buckets = BucketsFor(p_num);
+		return buckets > MinBuckets() ? buckets : MinBuckets();
+	}
+
+	// Нужен ли больший массив корзин, чтобы в контейнере было p_elements элементов.
+	bool Overloaded(int p_elements) const {
+		if (m_buckets == 1) {
+			return p_elements > kSmallSize;
 		}
+		return p_elements / static_cast<double>(m_buckets) >= m_max_load_factor;
+	}
+
+	static size_t TableBytes(int p_buckets) {
+		return p_buckets > 1 ? sizeof(NodeType*) * p_buckets : 0;
 	}
 
-	UnorderedMap(const UnorderedMap& p_other) : m_buckets(p_other.m_buckets), m_load_factor(p_other.m_load_factor),
-		m_max_load_factor(p_other.m_max_load_factor), m_hash_obj(p_other.m_hash_obj) {
-		m_table = new NodeType * [m_buckets] {};
-		const NodeType* cur_ptr = p_other.m_chains.GetHead();
+	void ResetTable(int p_buckets) {
+		m_buckets = p_buckets;
+		m_policy.Reset(m_buckets);
+		m_table = NewTable(m_buckets);
+	}
+
+	// Перевешивает существующие узлы на новый массив корзин: без копирования элементов и без выделения узлов.
+	void Rehash(int p_buckets) {
+		CompleteRehash();
+		STL_MAP_STAT(m_stats.RecordRehash();)
+		STL_MAP_STAT(MapCounters::Timer timer(m_stats);)
+		m_shrink_pending = false;
+		DeleteTable(m_table, m_buckets);
+		ResetTable(p_buckets);
+		NodeType* cur_ptr = m_chains.Detach();
 		while (cur_ptr) {
-			Insert(cur_ptr->m_pair);
-			cur_ptr = cur_ptr->m_next;
+			NodeType* next_ptr = cur_ptr->m_next;
+			int bucket_number = m_policy.Index(cur_ptr->m_hash);
+			m_chains.Link(cur_ptr, m_table[bucket_number], BucketId(bucket_number));
+			cur_ptr = next_ptr;
+		}
+	}
+
+	void StartIncrementalRehash(int p_buckets) {
+		CompleteRehash();
+		STL_MAP_STAT(m_stats.RecordRehash();)
+		m_old_table = m_table;
+		m_old_policy = m_policy;
+		m_old_buckets = m_buckets;
+		m_rehash_pos = 0;
+		m_parity = 1 - m_parity;
+		m_shrink_pending = false;
+		ResetTable(p_buckets);
+	}
+
+	void RehashStep(int p_count) {
+		STL_MAP_STAT(MapCounters::Timer timer(m_stats);)
+		for (int i = 0; i < p_count && m_rehash_pos < m_old_buckets; i++, m_rehash_pos++) {
+			NodeType*& old_head = m_old_table[m_rehash_pos];
+			while (old_head) {
+				NodeType* node = old_head;
+				m_chains.Unlink(node, old_head);
+				int bucket_number = m_policy.Index(node->m_hash);
+				m_chains.Link(node, m_table[bucket_number], BucketId(bucket_number));
+			}
+		}
+		if (m_rehash_pos == m_old_buckets) {
+			DeleteTable(m_old_table, m_old_buckets);
+			m_old_table = nullptr;
+			m_old_buckets = 0;
+			m_rehash_pos = 0;
+		}
+	}
+
+	void CompleteRehash() {
+		if (m_old_table) {
+			RehashStep(m_old_buckets);
+		}
+	}
+
+	/*
+	Вызывается перед вставкой. Переносит очередную порцию корзин незавершенного перехэширования,
+	при превышении m_max_load_factor увеличивает массив корзин, а при заполнении ниже m_min_load_factor
+	уменьшает его - только если с последнего изменения размера были удаления, чтобы не отменить Reserve.
+	Переносы делаются только при вставке: удаление во время обхода не должно менять порядок узлов.
+	*/
+	void GrowIfNeeded() {
+		if (m_old_table) {
+			RehashStep(kRehashStep);
+		}
+		int current_elements = m_chains.Size();
+		int buckets = m_buckets;
+		if (Overloaded(current_elements + 1)) {
+			buckets = BucketsFor(current_elements + 1);
+		}
+		else if (m_shrink_pending && (current_elements + 1) / static_cast<double>(m_buckets) < m_min_load_factor && m_buckets > 1) {
+			buckets = ShrunkBuckets(current_elements + 1);
+		}
+		if (buckets == m_buckets) {
+			return;
+		}
+		if (m_incremental_rehash) {
+			StartIncrementalRehash(buckets);
+		}
+		else {
+			Rehash(buckets);
+		}
+	}
+
+	/*
+	Переносит узлы (уже разложенные по m_table, без старого массива) в новый пул: подряд в одном слэбе
+	и в порядке обхода, так что цепочка каждой корзины лежит в памяти непрерывно. Старые слэбы освобождаются.
+	Ключ копируется, а значение перемещается, если ни то ни другое не бросает исключений; иначе пара копируется,
+	и при исключении контейнер остается прежним.
+	*/
+	void CompactNodes() {
+		if (m_chains.Size() == 0) {
+			m_chains.Clear();
+			return;
+		}
+		constexpr bool kRelocate = std::is_nothrow_copy_constructible<_KeyType>::value && std::is_nothrow_move_constructible<_DataType>::value;
+		ChainType chains(m_chains.GetResource());
+		chains.ReserveNodes(m_chains.Size());
+		NodeType* tail = nullptr;
+		for (NodeType* cur_ptr = m_chains.GetHead(); cur_ptr; cur_ptr = cur_ptr->m_next) {
+			if constexpr (kRelocate) {
+				tail = chains.EmplaceAfter(tail, cur_ptr->m_hash, cur_ptr->m_bucket_number, cur_ptr->m_pair.first, std::move(cur_ptr->m_pair.second));
+			}
+			else {
+				tail = chains.EmplaceAfter(tail, cur_ptr->m_hash, cur_ptr->m_bucket_number, cur_ptr->m_pair);
+			}
+		}
+		m_chains = std::move(chains);
+		for (NodeType* cur_ptr = m_chains.GetHead(); cur_ptr; cur_ptr = cur_ptr->m_next) {
+			if (!cur_ptr->m_prev || cur_ptr->m_prev->m_bucket_number != cur_ptr->m_bucket_number) {
+				m_table[cur_ptr->m_bucket_number / 2] = cur_ptr;
+			}
+		}
+	}
+
+	/*
+	Копирует устройство p_other: размеры и политики массивов корзин, незавершенное перехэширование, параметры.
+	Массивы выделяются пустыми, узлов в контейнере к этому моменту быть не должно.
+	*/
+	void CopyLayout(const UnorderedMap& p_other) {
+		m_buckets = p_other.m_buckets;
+		m_load_factor = p_other.m_load_factor;
+		m_max_load_factor = p_other.m_max_load_factor;
+		m_min_load_factor = p_other.m_min_load_factor;
+		m_shrink_pending = p_other.m_shrink_pending;
+		m_hash_obj = p_other.m_hash_obj;
+		m_key_equal = p_other.m_key_equal;
+		m_policy = p_other.m_policy;
+		m_table = NewTable(m_buckets);
+		m_old_policy = p_other.m_old_policy;
+		m_old_buckets = p_other.m_old_buckets;
+		m_old_table = p_other.m_old_table ? NewTable(m_old_buckets) : nullptr;
+		m_rehash_pos = p_other.m_rehash_pos;
+		m_parity = p_other.m_parity;
+		m_incremental_rehash = p_other.m_incremental_rehash;
+	}
+
+	/*
+	Копирует узлы p_other за один проход по его списку: узлы идут в том же порядке и с теми же хэшами и номерами
+	корзин, поэтому хэш-функция не вызывается, а начала цепочек - это узлы, у которых предыдущий из другой корзины.
+	Все узлы выделяются подряд в одном слэбе.
+	*/
+	void CloneNodes(const UnorderedMap& p_other) {
+		if (p_other.Size() == 0) {
+			return;
+		}
+		m_chains.ReserveNodes(p_other.Size());
+		NodeType* tail = nullptr;
+		for (const NodeType* cur_ptr = p_other.m_chains.GetHead(); cur_ptr; cur_ptr = cur_ptr->m_next) {
+			tail = m_chains.EmplaceAfter(tail, cur_ptr->m_hash, cur_ptr->m_bucket_number, cur_ptr->m_pair);
+			if (!cur_ptr->m_prev || cur_ptr->m_prev->m_bucket_number != cur_ptr->m_bucket_number) {
+				BucketHead(cur_ptr->m_bucket_number) = tail;
+			}
+		}
+	}
+
+	// Перемещение ничего не выделяет и бросает исключение, только если его бросает копирование хэш-функции или предиката.
+	static constexpr bool kNothrowSteal = std::is_nothrow_copy_assignable<_Hash>::value && std::is_nothrow_copy_assignable<_KeyEqual>::value;
+
+	void StealFrom(UnorderedMap& p_other) noexcept(kNothrowSteal) {
+		m_buckets = p_other.m_buckets;
+		m_load_factor = p_other.m_load_factor;
+		m_max_load_factor = p_other.m_max_load_factor;
+		m_min_load_factor = p_other.m_min_load_factor;
+		m_shrink_pending = p_other.m_shrink_pending;
+		m_hash_obj = p_other.m_hash_obj;
+		m_key_equal = p_other.m_key_equal;
+		m_policy = p_other.m_policy;
+		m_inline_bucket[0] = p_other.m_inline_bucket[0];
+		m_table = p_other.m_table == p_other.m_inline_bucket ? m_inline_bucket : p_other.m_table;
+		m_old_table = p_other.m_old_table == p_other.m_inline_bucket ? m_inline_bucket : p_other.m_old_table;
+		m_old_policy = p_other.m_old_policy;
+		m_old_buckets = p_other.m_old_buckets;
+		m_rehash_pos = p_other.m_rehash_pos;
+		m_parity = p_other.m_parity;
+		m_incremental_rehash = p_other.m_incremental_rehash;
+		p_other.m_max_load_factor = 1;                           // Т.к. p_other у нас может быть результатом функции move,
+		p_other.m_min_load_factor = 0;                           // мы не можем проигнорировать заполнение этих полей,
+		p_other.m_shrink_pending = false;
+		p_other.m_load_factor = 0;                               // ведь в таком случае объект, к которому была применена функция move
+		p_other.ResetTable(1);                                   // может перестать быть валидным. Встроенная корзина не выделяется.
+		p_other.m_old_table = nullptr;
+		p_other.m_old_buckets = 0;
+		p_other.m_rehash_pos = 0;
+	}
+public:
+	UnorderedMap() : UnorderedMap(std::pmr::get_default_resource()) {}
+
+	explicit UnorderedMap(std::pmr::memory_resource* p_resource) : m_buckets(1), m_load_factor(0.), m_max_load_factor(1.), m_min_load_factor(0.), m_shrink_pending(false), m_chains(p_resource),
+		m_old_table(nullptr), m_old_buckets(0), m_rehash_pos(0), m_parity(0), m_incremental_rehash(false) {
+		ResetTable(m_buckets);
+	}
+
+	explicit UnorderedMap(int p_buckets, std::pmr::memory_resource* p_resource = std::pmr::get_default_resource()) : m_load_factor(0.), m_max_load_factor(1.), m_min_load_factor(0.), m_shrink_pending(false), m_chains(p_resource),
+		m_old_table(nullptr), m_old_buckets(0), m_rehash_pos(0), m_parity(0), m_incremental_rehash(false) {
+		ResetTable(_BucketPolicy::RoundBuckets(p_buckets));
+	}
+
+	template<typename _Iter = iterator>
+	UnorderedMap(const _Iter& p_left, const _Iter& p_right) : UnorderedMap() {
+		InsertRange(p_left, p_right);
+	}
+
+	// Копия получает то же число корзин и тот же порядок элементов, что и p_other.
+	UnorderedMap(const UnorderedMap& p_other) : m_hash_obj(p_other.m_hash_obj), m_key_equal(p_other.m_key_equal) {
+		CopyLayout(p_other);
+		try {
+			CloneNodes(p_other);
+		}
+		catch (...) {
+			m_chains.Clear();
+			DeleteTable(m_table, m_buckets);
+			if (m_old_table) {
+				DeleteTable(m_old_table, m_old_buckets);
+			}
+			throw;
 		}
 	}
 
-	UnorderedMap(const std::initializer_list<PairType>& p_list) : UnorderedMap(p_list.size()) {
-		for (auto& elem : p_list) {
-			Insert(elem);
+	UnorderedMap(const std::initializer_list<PairType>& p_list) : UnorderedMap() {
+		if (static_cast<int>(p_list.size()) > kSmallSize) {
+			Rehash(_BucketPolicy::RoundBuckets(static_cast<int>(p_list.size())));
 		}
+		InsertRange(p_list.begin(), p_list.end());
 	};
 
-	UnorderedMap(UnorderedMap&& p_other) : m_buckets(p_other.m_buckets), m_load_factor(p_other.m_load_factor),
-		m_max_load_factor(p_other.m_max_load_factor), m_hash_obj(p_other.m_hash_obj), m_table(p_other.m_table) {
-		m_chains = move(p_other.m_chains);
-		p_other.m_buckets = 8;                                   // .. p_other       move,
-		p_other.m_max_load_factor = 1;                           //       ,
-		p_other.m_load_factor = 0;                               //     ,      move
-		p_other.m_table = new NodeType * [p_other.m_buckets]{};  //    .
+	UnorderedMap(UnorderedMap&& p_other) noexcept(kNothrowSteal) : m_chains(std::move(p_other.m_chains)) {
+		StealFrom(p_other);
 	}
 
 	~UnorderedMap() {
 		m_chains.Clear();
-		delete[] m_table;
+		DeleteTable(m_table, m_buckets);
+		if (m_old_table) {
+			DeleteTable(m_old_table, m_old_buckets);
+		}
 	}
 
 	iterator begin() {
@@ -82,85 +535,323 @@ public:
 		return iterator();
 	}
 
+	const_iterator begin() const {
+		return const_iterator(m_chains.GetHead());
+	}
+
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	const_iterator cend() const {
+		return end();
+	}
+
 	UnorderedMap& operator=(const UnorderedMap& p_other) {
 		if (this == &p_other) {
 			return *this;
 		}
 		m_chains.Clear();
-		delete[] m_table;
-		m_table = new NodeType * [p_other.m_buckets]{};
-		const NodeType* cur_ptr = p_other.m_chains.GetHead();
-		while (cur_ptr) {
-			Insert(cur_ptr->m_pair);
-			cur_ptr = cur_ptr->m_next;
+		DeleteTable(m_table, m_buckets);
+		if (m_old_table) {
+			DeleteTable(m_old_table, m_old_buckets);
+		}
+		CopyLayout(p_other);
+		try {
+			CloneNodes(p_other);
+		}
+		catch (...) {
+			Clear();
+			throw;
 		}
 		return *this;
 	}
 
-	UnorderedMap& operator=(UnorderedMap&& p_other) {
-		if (this = &p_other) {
+	UnorderedMap& operator=(UnorderedMap&& p_other) noexcept(kNothrowSteal) {
+		if (this == &p_other) {
 			return *this;
 		}
 		m_chains.Clear();
-		delete[] m_table;
-		m_chains = move(p_other.m_chains);
-		m_buckets = p_other.m_buckets;
-		m_load_factor = p_other.m_load_factor;
-		m_max_load_factor = p_other.m_max_load_factor;
-		m_hash_obj = p_other.m_hash_obj;
-		m_table = p_other.m_table;
-		p_other.m_buckets = 8;
-		p_other.m_max_load_factor = 1;
-		p_other.m_table = new NodeType * [p_other.m_buckets]{};
-		p_other.m_load_factor = 0;
+		DeleteTable(m_table, m_buckets);
+		if (m_old_table) {
+			DeleteTable(m_old_table, m_old_buckets);
+		}
+		m_chains = std::move(p_other.m_chains);
+		StealFrom(p_other);
 		return *this;
 	}
 
 
 	const iterator Insert(const PairType& p_pair) {
-		int bucket_number = m_hash_obj(p_pair.first) % m_buckets;
-		int current_elements = m_chains.Size();
-		if ((current_elements + 1) / static_cast<double>(m_buckets) >= m_max_load_factor) {
-			Reserve(current_elements + 1);
+		GrowIfNeeded();
+		size_t hash = m_hash_obj(p_pair.first);
+		NodeType* node = FindNode(p_pair.first, hash);
+		if (node) {
+			node->m_pair.second = p_pair.second;
+			return iterator(node);
 		}
-		return m_chains.Insert(p_pair, m_table[bucket_number], bucket_number);
+		return iterator(EmplaceNode(hash, p_pair));
 	}
 
 	const iterator Insert(PairType&& p_pair) {
-		int bucket_number = m_hash_obj(p_pair.first) % m_buckets;
-		int current_elements = m_chains.Size();
-		if ((current_elements + 1) / static_cast<double>(m_buckets) >= m_max_load_factor) {
-			Reserve(current_elements + 1);
+		GrowIfNeeded();
+		size_t hash = m_hash_obj(p_pair.first);
+		NodeType* node = FindNode(p_pair.first, hash);
+		if (node) {
+			node->m_pair.second = std::move(p_pair.second);
+			return iterator(node);
+		}
+		return iterator(EmplaceNode(hash, std::move(p_pair)));
+	}
+
+	/*
+	Массовая вставка (с той же семантикой, что и Insert для каждого элемента). Если длина диапазона известна заранее
+	(итератор не слабее однонаправленного), массив корзин и узлы выделяются один раз, а ключи хэшируются пачками
+	по kBatchSize до обращений к таблице. Однопроходные диапазоны вставляются поэлементно.
+	*/
+	template<typename _Iter>
+	void InsertRange(_Iter p_first, _Iter p_last) {
+		if constexpr (IsForwardIterator<_Iter>::value) {
+			PrepareBulkInsert(static_cast<int>(std::distance(p_first, p_last)));
+			size_t hashes[kBatchSize];
+			while (p_first != p_last) {
+				_Iter batch_first = p_first;
+				int count = 0;
+				for (; count < kBatchSize && p_first != p_last; count++, ++p_first) {
+					hashes[count] = m_hash_obj((*p_first).first);
+				}
+				for (int i = 0; i < count; i++, ++batch_first) {
+					InsertHashed(*batch_first, hashes[i]);
+				}
+			}
+		}
+		else {
+			for (; p_first != p_last; ++p_first) {
+				Insert(*p_first);
+			}
+		}
+	}
+
+	// То же для заранее посчитанных хэшей: p_hashes[i] должен совпадать с _Hash()(ключ i-го элемента).
+	template<typename _Iter, typename _HashIter>
+	void InsertRange(_Iter p_first, _Iter p_last, _HashIter p_hashes) {
+		if constexpr (IsForwardIterator<_Iter>::value) {
+			PrepareBulkInsert(static_cast<int>(std::distance(p_first, p_last)));
+		}
+		for (; p_first != p_last; ++p_first, ++p_hashes) {
+			InsertHashed(*p_first, static_cast<size_t>(*p_hashes));
+		}
+	}
+
+	/*
+	Emplace конструирует пару прямо в узле из p_args; если ключ уже есть, узел уничтожается, а контейнер не меняется.
+	TryEmplace сначала ищет ключ и конструирует значение из p_args, только если ключа нет.
+	InsertOrAssign присваивает значение существующему элементу или создает новый.
+	Во всех трех случаях второй элемент результата - признак того, что элемент был вставлен.
+	*/
+	template<typename... _Args>
+	std::pair<iterator, bool> Emplace(_Args&&... p_args) {
+		GrowIfNeeded();
+		NodeType* node = m_chains.Construct(std::forward<_Args>(p_args)...);
+		NodeType* existing;
+		try {
+			node->m_hash = m_hash_obj(node->m_pair.first);
+			existing = FindNode(node->m_pair.first, node->m_hash);
+		}
+		catch (...) {
+			m_chains.Destroy(node);
+			throw;
 		}
-		return m_chains.Insert(p_pair, m_table[bucket_number], bucket_number);
+		if (existing) {
+			m_chains.Destroy(node);
+			return { iterator(existing), false };
+		}
+		int bucket_number = m_policy.Index(node->m_hash);
+		m_chains.LinkNew(node, m_table[bucket_number], BucketId(bucket_number));
+		STL_MAP_STAT(m_stats.RecordInsert();)
+		return { iterator(node), true };
+	}
+
+	template<typename... _Args>
+	std::pair<iterator, bool> TryEmplace(const _KeyType& p_key, _Args&&... p_args) {
+		return TryEmplaceImpl(p_key, std::forward<_Args>(p_args)...);
+	}
+
+	template<typename... _Args>
+	std::pair<iterator, bool> TryEmplace(_KeyType&& p_key, _Args&&... p_args) {
+		return TryEmplaceImpl(std::move(p_key), std::forward<_Args>(p_args)...);
+	}
+
+	template<typename _Value>
+	std::pair<iterator, bool> InsertOrAssign(const _KeyType& p_key, _Value&& p_value) {
+		return InsertOrAssignImpl(p_key, std::forward<_Value>(p_value));
+	}
+
+	template<typename _Value>
+	std::pair<iterator, bool> InsertOrAssign(_KeyType&& p_key, _Value&& p_value) {
+		return InsertOrAssignImpl(std::move(p_key), std::forward<_Value>(p_value));
 	}
 
 	const _DataType& At(const _KeyType& p_key) const {
-		int bucket_number = m_hash_obj(p_key) % m_buckets;
-		return m_chains.At(m_table[bucket_number], p_key, bucket_number);
+		NodeType* node = LookupNode(p_key);
+		if (!node) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return node->m_pair.second;
 	}
 
 	/*
-	  , .. operator[]        
-	   second  . -> .. operator[]      .
+	Константной версии нет, т.к. operator[] при вызове по несуществующему ключу создает в контейнере
+	пару со значением second по умолчанию. -> т.е. operator[] в любом случае способен изменять контейнер.
 	*/
 	_DataType& operator[](const _KeyType& p_key) {
-		int bucket_number = m_hash_obj(p_key) % m_buckets;
-		int current_elements = m_chains.Size();
-		if ((current_elements + 1) / static_cast<double>(m_buckets) >= m_max_load_factor) {
-			Reserve(current_elements + 1);
-		}
-		return m_chains.GetReferenceToElement(m_table[bucket_number], p_key, bucket_number);
+		return TryEmplaceImpl(p_key).first->second;
+	}
+
+	_DataType& operator[](_KeyType&& p_key) {
+		return TryEmplaceImpl(std::move(p_key)).first->second;
+	}
+
+	/*
+	Поиск без вставки и без исключений: промах - обычный результат, а не ошибка.
+	Перегрузки с шаблонным _Key доступны при прозрачных _Hash и _KeyEqual (например, TransparentStringHash и std::equal_to<>).
+	*/
+	iterator Find(const _KeyType& p_key) {
+		return iterator(LookupNode(p_key));
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	iterator Find(const _Key& p_key) {
+		return iterator(LookupNode(p_key));
+	}
+
+	const_iterator Find(const _KeyType& p_key) const {
+		return const_iterator(LookupNode(p_key));
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	const_iterator Find(const _Key& p_key) const {
+		return const_iterator(LookupNode(p_key));
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		return LookupNode(p_key) != nullptr;
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	bool Contains(const _Key& p_key) const {
+		return LookupNode(p_key) != nullptr;
+	}
+
+	int Count(const _KeyType& p_key) const {
+		return Contains(p_key) ? 1 : 0;
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	int Count(const _Key& p_key) const {
+		return Contains(p_key) ? 1 : 0;
+	}
+
+	// Указатель на значение или nullptr, если ключа нет.
+	_DataType* TryGet(const _KeyType& p_key) {
+		NodeType* node = LookupNode(p_key);
+		return node ? &node->m_pair.second : nullptr;
+	}
+
+	const _DataType* TryGet(const _KeyType& p_key) const {
+		NodeType* node = LookupNode(p_key);
+		return node ? &node->m_pair.second : nullptr;
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	_DataType* TryGet(const _Key& p_key) {
+		NodeType* node = LookupNode(p_key);
+		return node ? &node->m_pair.second : nullptr;
+	}
+
+	template<typename _Key, typename = EnableIfTransparent<_Key>>
+	const _DataType* TryGet(const _Key& p_key) const {
+		NodeType* node = LookupNode(p_key);
+		return node ? &node->m_pair.second : nullptr;
+	}
+
+	/*
+	Пакетные варианты Find и TryGet: для каждого ключа из [p_first, p_last) в p_out по порядку пишется
+	итератор (end() при промахе) или указатель на значение (nullptr при промахе).
+	Итератор ключей должен разыменовываться в ссылку (допускать повторный проход).
+	*/
+	template<typename _KeyIter, typename _OutIter>
+	_OutIter FindMany(_KeyIter p_first, _KeyIter p_last, _OutIter p_out) {
+		FindBatched(p_first, p_last, [&p_out](NodeType* p_node) {
+			*p_out = iterator(p_node);
+			++p_out;
+		});
+		return p_out;
+	}
+
+	template<typename _KeyIter, typename _OutIter>
+	_OutIter TryGetMany(_KeyIter p_first, _KeyIter p_last, _OutIter p_out) {
+		FindBatched(p_first, p_last, [&p_out](NodeType* p_node) {
+			*p_out = p_node ? &p_node->m_pair.second : nullptr;
+			++p_out;
+		});
+		return p_out;
+	}
+
+	template<typename _KeyIter, typename _OutIter>
+	_OutIter TryGetMany(_KeyIter p_first, _KeyIter p_last, _OutIter p_out) const {
+		FindBatched(p_first, p_last, [&p_out](const NodeType* p_node) {
+			*p_out = p_node ? &p_node->m_pair.second : nullptr;
+			++p_out;
+		});
+		return p_out;
 	}
 
 	void Erase(const _KeyType& p_key) {
-		int bucket_number = m_hash_obj(p_key) % m_buckets;
-		m_chains.Erase(m_table[bucket_number], p_key, bucket_number);
+		NodeType* node = FindNode(p_key, m_hash_obj(p_key));
+		if (!node) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		STL_MAP_STAT(m_stats.RecordErase();)
+		m_shrink_pending = true;
+		m_chains.Erase(node, BucketHead(node->m_bucket_number));
 	}
 
 	iterator Erase(const iterator& p_iter) {
-		int bucket_number = p_iter.GetBucketNumber();
-		return m_chains.Erase(p_iter, m_table[bucket_number], bucket_number);
+		NodeType* node = p_iter.GetPtr();
+		if (!node) {
+			throw IteratorError("IteratorError: iterator does not point to an element.");
+		}
+		STL_MAP_STAT(m_stats.RecordErase();)
+		m_shrink_pending = true;
+		return iterator(m_chains.Erase(node, BucketHead(node->m_bucket_number)));
+	}
+
+	/*
+	Делит контейнер на не более чем p_parts частей из подряд идущих корзин для параллельного обхода.
+	Незавершенное перехэширование сначала доводится до конца, чтобы все узлы висели на одном массиве.
+	Части действительны, пока контейнер не изменяется.
+	*/
+	std::vector<bucket_range> Split(int p_parts) {
+		if (p_parts <= 0) {
+			throw InvalidValueError("InvalidValueError: invalid part count.");
+		}
+		CompleteRehash();
+		if (p_parts > m_buckets) {
+			p_parts = m_buckets;
+		}
+		std::vector<bucket_range> parts;
+		parts.reserve(p_parts);
+		for (int i = 0; i < p_parts; i++) {
+			int first = static_cast<int>(static_cast<long long>(m_buckets) * i / p_parts);
+			int last = static_cast<int>(static_cast<long long>(m_buckets) * (i + 1) / p_parts);
+			parts.emplace_back(m_table, first, last, m_parity);
+		}
+		return parts;
 	}
 
 	double MaxLoadFactor() const {
@@ -168,25 +859,68 @@ public:
 	}
 
 	void MaxLoadFactor(double p_max_load_factor) {
-		if (p_max_load_factor <= 0.0) {
+		if (!(p_max_load_factor > 0.0) || m_min_load_factor * 4 >= p_max_load_factor) {
 			throw InvalidValueError("InvalidValueError: invalid hash load factor.");
 		}
 		m_max_load_factor = p_max_load_factor;
 	}
 
+	double MinLoadFactor() const {
+		return m_min_load_factor;
+	}
+
+	/*
+	Если после удалений заполнение падает ниже p_min_load_factor, следующая вставка уменьшает массив корзин, а Clear
+	возвращает его к размеру по умолчанию. 0 (по умолчанию) отключает сжатие. Порог должен быть меньше четверти
+	MaxLoadFactor: после роста или сжатия заполнение не ниже этой величины, и массив не будет расти и сжиматься поочередно.
+	*/
+	void MinLoadFactor(double p_min_load_factor) {
+		if (p_min_load_factor < 0.0 || p_min_load_factor * 4 >= m_max_load_factor) {
+			throw InvalidValueError("InvalidValueError: invalid hash load factor.");
+		}
+		m_min_load_factor = p_min_load_factor;
+	}
+
+	/*
+	При включенном режиме рост таблицы при вставке не переносит все узлы сразу: каждая следующая вставка
+	переносит несколько корзин старого массива, так что ни одна операция не платит за перехэширование целиком.
+	*/
+	bool IncrementalRehash() const {
+		return m_incremental_rehash;
+	}
+
+	void IncrementalRehash(bool p_enabled) {
+		if (!p_enabled) {
+			CompleteRehash();
+		}
+		m_incremental_rehash = p_enabled;
+	}
+
 	void Reserve(int p_num) {
 		if (p_num <= 0) {
 			throw InvalidValueError("InvalidValueError: invalid hash bucket count.");
 		}
-		delete[] m_table;
-		m_buckets = p_num * static_cast<int>(2 / m_max_load_factor);
-		m_table = new NodeType * [m_buckets] {};
-		ChainType temp_chains = std::move(m_chains);
-		NodeType* cur_ptr = temp_chains.GetHead();
-		while (cur_ptr) {
-			Insert(cur_ptr->m_pair);
-			cur_ptr = cur_ptr->m_next;
+		Rehash(BucketsFor(p_num));
+	}
+
+	// Перестраивает массив на p_buckets корзин (с округлением политики), но не меньше, чем нужно текущим элементам.
+	void SetBucketCount(int p_buckets) {
+		if (p_buckets <= 0) {
+			throw InvalidValueError("InvalidValueError: invalid hash bucket count.");
 		}
+		int buckets = _BucketPolicy::RoundBuckets(p_buckets);
+		int needed = BucketsFor(Size());
+		Rehash(buckets > needed ? buckets : needed);
+	}
+
+	/*
+	Уменьшает массив корзин под текущее число элементов и переносит узлы в новую память подряд в порядке обхода
+	(см. CompactNodes): обход и поиск снова идут по соседним адресам, а память разреженных слэбов возвращается.
+	В отличие от остальных операций, делает недействительными все итераторы, указатели и ссылки на элементы.
+	*/
+	void ShrinkToFit() {
+		Rehash(ShrunkBuckets(Size()));
+		CompactNodes();
 	}
 
 	bool Empty() const {
@@ -200,11 +934,27 @@ public:
 	void Clear() {
 		m_chains.Clear();
 		m_load_factor = 0;
+		m_shrink_pending = false;
+		if (m_old_table) {
+			DeleteTable(m_old_table, m_old_buckets);
+			m_old_table = nullptr;
+			m_old_buckets = 0;
+			m_rehash_pos = 0;
+		}
+		if (m_min_load_factor > 0 && m_buckets > 1) {
+			DeleteTable(m_table, m_buckets);
+			ResetTable(1);
+			return;
+		}
 		for (int i = 0; i < m_buckets; i++) {
 			m_table[i] = nullptr;
 		}
 	}
 
+	_Hash GetHashFunction() const {
+		return m_hash_obj;
+	}
+
 	int GetBucketCount() const {
 		return m_buckets;
 	}
@@ -212,4 +962,40 @@ public:
 	double GetLoadFactor() const {
 		return Size() / static_cast<double>(m_buckets);
 	}
+
+	/*
+	Снимок статистики (см. Stats.h). Длины цепочек считаются одним проходом по списку, т.е. за O(Size() + число корзин);
+	счетчики поисков, вставок и перехэширований заполнены только при STL_MAP_STATS.
+	*/
+	MapStats GetStats() const {
+		MapStats stats;
+		STL_MAP_STAT(m_stats.CopyTo(stats);)
+		stats.m_size = Size();
+		stats.m_buckets = m_buckets;
+		stats.m_old_buckets = m_old_table ? m_old_buckets : 0;
+		stats.m_load_factor = GetLoadFactor();
+		stats.m_node_bytes = m_chains.GetAllocatedBytes();
+		stats.m_table_bytes = TableBytes(m_buckets) + (m_old_table ? TableBytes(m_old_buckets) : 0);
+		uint64_t chains = 0;
+		const NodeType* cur_ptr = m_chains.GetHead();
+		while (cur_ptr) {
+			uint64_t length = 0;
+			int bucket_number = cur_ptr->m_bucket_number;
+			for (; cur_ptr && cur_ptr->m_bucket_number == bucket_number; cur_ptr = cur_ptr->m_next) {
+				length++;
+			}
+			chains++;
+			stats.m_chain_histogram[length < MapStats::kHistogramSize ? length : MapStats::kHistogramSize - 1]++;
+			if (length > stats.m_max_chain) {
+				stats.m_max_chain = length;
+			}
+		}
+		stats.m_chain_histogram[0] = stats.m_buckets + stats.m_old_buckets - chains;
+		return stats;
+	}
+
+	// Обнуляет счетчики горячего пути; при выключенной статистике ничего не делает.
+	void ResetStats() {
+		STL_MAP_STAT(m_stats.Reset();)
+	}
 };
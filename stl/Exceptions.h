@@ -9,7 +9,7 @@ private:
 public:
 	InvalidValueError(const std::string& p_error);
 
-	const char* what() const;
+	const char* what() const noexcept;
 };
 
 
@@ -19,7 +19,7 @@ private:
 public:
 	ItemNotFoundError(const std::string& p_error);
 
-	const char* what() const;
+	const char* what() const noexcept;
 };
 
 
@@ -29,6 +29,16 @@ private:
 public:
 	IteratorError(const std::string& p_error);
 
-	const char* what() const;
+	const char* what() const noexcept;
 };
 
+
+
+class FileError : public std::exception {
+private:
+	std::string m_error;
+public:
+	FileError(const std::string& p_error);
+
+	const char* what() const noexcept;
+};
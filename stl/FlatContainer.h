@@ -0,0 +1,521 @@
+#pragma once
+#include "Exceptions.h"
+#include "Hash.h"
+#include "Iterator.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STL_FLAT_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/*
+Группа из 16 подряд идущих управляющих байтов таблицы. Все сравнения выполняются сразу для всей группы
+(одна инструкция SSE2), результат - битовая маска, где i-й бит соответствует i-му слоту группы.
+*/
+class FlatGroup {
+public:
+	static constexpr int kWidth = 16;
+
+	explicit FlatGroup(const signed char* p_ctrl) {
+#ifdef STL_FLAT_SSE2
+		m_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_ctrl));
+#else
+		std::memcpy(m_ctrl, p_ctrl, kWidth);
+#endif
+	}
+
+	uint32_t Match(signed char p_h2) const {
+#ifdef STL_FLAT_SSE2
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(p_h2), m_ctrl)));
+#else
+		uint32_t mask = 0;
+		for (int i = 0; i < kWidth; i++) {
+			mask |= static_cast<uint32_t>(m_ctrl[i] == p_h2) << i;
+		}
+		return mask;
+#endif
+	}
+
+	uint32_t MatchEmpty() const {
+		return Match(FlatCtrl::kEmpty);
+	}
+
+	// У пустых и удаленных слотов установлен старший бит, у занятых - нет.
+	uint32_t MatchEmptyOrDeleted() const {
+#ifdef STL_FLAT_SSE2
+		return static_cast<uint32_t>(_mm_movemask_epi8(m_ctrl));
+#else
+		uint32_t mask = 0;
+		for (int i = 0; i < kWidth; i++) {
+			mask |= static_cast<uint32_t>(m_ctrl[i] < 0) << i;
+		}
+		return mask;
+#endif
+	}
+
+	static int LowestBit(uint32_t p_mask) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, p_mask);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctz(p_mask);
+#endif
+	}
+
+private:
+#ifdef STL_FLAT_SSE2
+	__m128i m_ctrl;
+#else
+	signed char m_ctrl[kWidth];
+#endif
+};
+
+
+/*
+Хэш-таблица с открытой адресацией: пары лежат в одном непрерывном массиве слотов, а на каждый слот приходится
+один управляющий байт с 7 битами хэша. Поиск просматривает группы по 16 управляющих байтов, поэтому промах
+и попадание обычно затрагивают одну-две кэш-линии вместо цепочки указателей.
+Интерфейс повторяет UnorderedMap; в отличие от него, вставка может перемещать элементы, делая недействительными
+итераторы и ссылки на значения.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>>
+class FlatUnorderedMap {
+private:
+	using PairType = std::pair<const _KeyType, _DataType>;
+public:
+	using iterator = FlatUnorderedMapIterator<_KeyType, _DataType>;
+	using const_iterator = FlatUnorderedMapIterator<_KeyType, _DataType, true>;
+
+private:
+	static constexpr size_t kNpos = static_cast<size_t>(-1);
+
+	size_t m_capacity;       // число слотов: 0 или степень двойки, не меньшая FlatGroup::kWidth
+	size_t m_size;
+	size_t m_growth_left;    // сколько пустых слотов еще можно занять, не превысив загрузку 7/8
+	_Hash m_hash_obj;
+	signed char* m_ctrl;     // m_capacity управляющих байтов и завершающий kSentinel
+	PairType* m_slots;
+
+	static signed char* EmptyCtrl() {
+		static signed char ctrl[1] = { FlatCtrl::kSentinel };
+		return ctrl;
+	}
+
+	uint64_t HashOf(const _KeyType& p_key) const {
+		return MixHash(static_cast<uint64_t>(m_hash_obj(p_key)));
+	}
+
+	static signed char H2(uint64_t p_hash) {
+		return static_cast<signed char>(p_hash & 0x7F);
+	}
+
+	static size_t NormalizeCapacity(size_t p_elements) {
+		size_t capacity = FlatGroup::kWidth;
+		while (capacity - capacity / 8 < p_elements) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	size_t FindIndex(const _KeyType& p_key, uint64_t p_hash) const {
+		if (!m_capacity) {
+			return kNpos;
+		}
+		size_t mask = m_capacity / FlatGroup::kWidth - 1;
+		size_t group = static_cast<size_t>(p_hash >> 7) & mask;
+		for (size_t step = 1;; step++) {
+			size_t offset = group * FlatGroup::kWidth;
+			FlatGroup ctrl(m_ctrl + offset);
+			for (uint32_t bits = ctrl.Match(H2(p_hash)); bits; bits &= bits - 1) {
+				size_t index = offset + FlatGroup::LowestBit(bits);
+				if (m_slots[index].first == p_key) {
+					return index;
+				}
+			}
+			if (ctrl.MatchEmpty()) {
+				return kNpos;
+			}
+			group = (group + step) & mask;
+		}
+	}
+
+	static size_t FindInsertSlot(const signed char* p_ctrl, size_t p_capacity, uint64_t p_hash) {
+		size_t mask = p_capacity / FlatGroup::kWidth - 1;
+		size_t group = static_cast<size_t>(p_hash >> 7) & mask;
+		for (size_t step = 1;; step++) {
+			size_t offset = group * FlatGroup::kWidth;
+			uint32_t bits = FlatGroup(p_ctrl + offset).MatchEmptyOrDeleted();
+			if (bits) {
+				return offset + FlatGroup::LowestBit(bits);
+			}
+			group = (group + step) & mask;
+		}
+	}
+
+	size_t FindInsertSlot(uint64_t p_hash) const {
+		return FindInsertSlot(m_ctrl, m_capacity, p_hash);
+	}
+
+	// Выделяет пустые массивы на p_capacity слотов; p_ctrl и p_slots меняются, только если выделились оба.
+	static void AllocateArrays(size_t p_capacity, signed char*& p_ctrl, PairType*& p_slots) {
+		signed char* ctrl = new signed char[p_capacity + 1];
+		try {
+			p_slots = static_cast<PairType*>(::operator new(sizeof(PairType) * p_capacity));
+		}
+		catch (...) {
+			delete[] ctrl;
+			throw;
+		}
+		std::memset(ctrl, static_cast<unsigned char>(FlatCtrl::kEmpty), p_capacity);
+		ctrl[p_capacity] = FlatCtrl::kSentinel;
+		p_ctrl = ctrl;
+	}
+
+	static void DestroySlots(signed char* p_ctrl, PairType* p_slots, size_t p_capacity) {
+		for (size_t i = 0; i < p_capacity; i++) {
+			if (p_ctrl[i] >= 0) {
+				p_slots[i].~PairType();
+			}
+		}
+	}
+
+	void Allocate(size_t p_capacity) {
+		AllocateArrays(p_capacity, m_ctrl, m_slots);
+		m_capacity = p_capacity;
+		m_growth_left = m_capacity - m_capacity / 8;
+	}
+
+	void Deallocate() {
+		if (m_capacity) {
+			delete[] m_ctrl;
+			::operator delete(m_slots);
+		}
+		m_capacity = 0;
+		m_growth_left = 0;
+		m_ctrl = EmptyCtrl();
+		m_slots = nullptr;
+	}
+
+	void DestroySlots() {
+		DestroySlots(m_ctrl, m_slots, m_capacity);
+	}
+
+	/*
+	Переносит элементы в новые массивы на p_capacity слотов. Ключ в паре константный, перемещать его нельзя:
+	ключ копируется, а значение перемещается, если ни это, ни хэширование не бросают исключений. Иначе пары
+	копируются, и при исключении новые массивы освобождаются, а контейнер остается прежним.
+	*/
+	void Rehash(size_t p_capacity) {
+		constexpr bool kRelocate = std::is_nothrow_copy_constructible<_KeyType>::value && std::is_nothrow_move_constructible<_DataType>::value &&
+			noexcept(std::declval<const _Hash&>()(std::declval<const _KeyType&>()));
+		signed char* ctrl;
+		PairType* slots;
+		AllocateArrays(p_capacity, ctrl, slots);
+		try {
+			for (size_t i = 0; i < m_capacity; i++) {
+				if (m_ctrl[i] >= 0) {
+					uint64_t hash = HashOf(m_slots[i].first);
+					size_t index = FindInsertSlot(ctrl, p_capacity, hash);
+					if constexpr (kRelocate) {
+						new (slots + index) PairType(m_slots[i].first, std::move(m_slots[i].second));
+						m_slots[i].~PairType();
+					}
+					else {
+						new (slots + index) PairType(m_slots[i]);
+					}
+					ctrl[index] = H2(hash);
+				}
+			}
+		}
+		catch (...) {
+			DestroySlots(ctrl, slots, p_capacity);
+			delete[] ctrl;
+			::operator delete(slots);
+			throw;
+		}
+		if constexpr (!kRelocate) {
+			DestroySlots();
+		}
+		Deallocate();
+		m_capacity = p_capacity;
+		m_ctrl = ctrl;
+		m_slots = slots;
+		m_growth_left = m_capacity - m_capacity / 8 - m_size;
+	}
+
+	/*
+	Возвращает индекс слота с ключом p_key (или свободного слота для него) и признак того, что ключа еще нет.
+	Свободный слот не помечается занятым: это делает ConstructAt после успешного создания пары.
+	При нехватке места таблица перестраивается: если значительную часть слотов занимают удаленные элементы -
+	в том же размере, иначе - с удвоением.
+	*/
+	std::pair<size_t, bool> FindOrPrepareInsert(const _KeyType& p_key, uint64_t p_hash) {
+		size_t index = FindIndex(p_key, p_hash);
+		if (index != kNpos) {
+			return { index, false };
+		}
+		if (!m_growth_left) {
+			if (m_capacity && m_size <= (m_capacity - m_capacity / 8) / 2) {
+				Rehash(m_capacity);
+			}
+			else {
+				Rehash(NormalizeCapacity(m_size + 1));
+			}
+		}
+		return { FindInsertSlot(p_hash), true };
+	}
+
+	// Создает пару в свободном слоте и только затем занимает его: если конструктор бросает, контейнер не меняется.
+	template<typename... _Args>
+	void ConstructAt(size_t p_index, uint64_t p_hash, _Args&&... p_args) {
+		new (m_slots + p_index) PairType(std::forward<_Args>(p_args)...);
+		if (m_ctrl[p_index] == FlatCtrl::kEmpty) {
+			m_growth_left--;
+		}
+		m_ctrl[p_index] = H2(p_hash);
+		m_size++;
+	}
+
+	void EraseIndex(size_t p_index) {
+		m_slots[p_index].~PairType();
+		m_size--;
+		/*
+		Если в группе уже есть пустой слот, то группа никогда не была заполнена целиком и ни одна
+		последовательность проб через нее не проходила -> слот можно сразу пометить пустым.
+		*/
+		size_t offset = p_index & ~static_cast<size_t>(FlatGroup::kWidth - 1);
+		if (FlatGroup(m_ctrl + offset).MatchEmpty()) {
+			m_ctrl[p_index] = FlatCtrl::kEmpty;
+			m_growth_left++;
+		}
+		else {
+			m_ctrl[p_index] = FlatCtrl::kDeleted;
+		}
+	}
+
+	void CopyFrom(const FlatUnorderedMap& p_other) {
+		if (!p_other.m_capacity) {
+			return;
+		}
+		Allocate(p_other.m_capacity);
+		try {
+			for (size_t i = 0; i < m_capacity; i++) {
+				if (p_other.m_ctrl[i] >= 0) {
+					new (m_slots + i) PairType(p_other.m_slots[i]);
+				}
+				m_ctrl[i] = p_other.m_ctrl[i];
+			}
+		}
+		catch (...) {
+			DestroySlots();
+			Deallocate();
+			throw;
+		}
+		m_size = p_other.m_size;
+		m_growth_left = p_other.m_growth_left;
+	}
+
+	void Steal(FlatUnorderedMap& p_other) noexcept {
+		m_capacity = p_other.m_capacity;
+		m_size = p_other.m_size;
+		m_growth_left = p_other.m_growth_left;
+		m_ctrl = p_other.m_ctrl;
+		m_slots = p_other.m_slots;
+		p_other.m_capacity = 0;
+		p_other.m_size = 0;
+		p_other.m_growth_left = 0;
+		p_other.m_ctrl = EmptyCtrl();
+		p_other.m_slots = nullptr;
+	}
+
+public:
+	FlatUnorderedMap() : m_capacity(0), m_size(0), m_growth_left(0), m_ctrl(EmptyCtrl()), m_slots(nullptr) {}
+
+	explicit FlatUnorderedMap(int p_buckets) : FlatUnorderedMap() {
+		if (p_buckets > 0) {
+			Allocate(NormalizeCapacity(p_buckets));
+		}
+	}
+
+	template<typename _Iter = iterator>
+	FlatUnorderedMap(const _Iter& p_left, const _Iter& p_right) : FlatUnorderedMap() {
+		for (auto cur = p_left; cur != p_right; cur++) {
+			Insert(*cur);
+		}
+	}
+
+	FlatUnorderedMap(const std::initializer_list<PairType>& p_list) : FlatUnorderedMap(static_cast<int>(p_list.size())) {
+		for (auto& elem : p_list) {
+			Insert(elem);
+		}
+	}
+
+	FlatUnorderedMap(const FlatUnorderedMap& p_other) : FlatUnorderedMap() {
+		m_hash_obj = p_other.m_hash_obj;
+		CopyFrom(p_other);
+	}
+
+	FlatUnorderedMap(FlatUnorderedMap&& p_other) noexcept(std::is_nothrow_copy_constructible<_Hash>::value) : m_hash_obj(p_other.m_hash_obj) {
+		Steal(p_other);
+	}
+
+	~FlatUnorderedMap() {
+		DestroySlots();
+		Deallocate();
+	}
+
+	FlatUnorderedMap& operator=(const FlatUnorderedMap& p_other) {
+		if (this == &p_other) {
+			return *this;
+		}
+		DestroySlots();
+		Deallocate();
+		m_size = 0;
+		m_hash_obj = p_other.m_hash_obj;
+		CopyFrom(p_other);
+		return *this;
+	}
+
+	FlatUnorderedMap& operator=(FlatUnorderedMap&& p_other) noexcept(std::is_nothrow_copy_assignable<_Hash>::value) {
+		if (this == &p_other) {
+			return *this;
+		}
+		m_hash_obj = p_other.m_hash_obj;
+		DestroySlots();
+		Deallocate();
+		Steal(p_other);
+		return *this;
+	}
+
+	iterator begin() {
+		return iterator(m_ctrl, m_slots);
+	}
+
+	iterator end() {
+		return iterator();
+	}
+
+	const_iterator begin() const {
+		return const_iterator(m_ctrl, m_slots);
+	}
+
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	const_iterator cbegin() const {
+		return begin();
+	}
+
+	const_iterator cend() const {
+		return end();
+	}
+
+	const iterator Insert(const PairType& p_pair) {
+		uint64_t hash = HashOf(p_pair.first);
+		std::pair<size_t, bool> slot = FindOrPrepareInsert(p_pair.first, hash);
+		if (slot.second) {
+			ConstructAt(slot.first, hash, p_pair);
+		}
+		else {
+			m_slots[slot.first].second = p_pair.second;
+		}
+		return iterator(m_ctrl + slot.first, m_slots + slot.first);
+	}
+
+	const iterator Insert(PairType&& p_pair) {
+		uint64_t hash = HashOf(p_pair.first);
+		std::pair<size_t, bool> slot = FindOrPrepareInsert(p_pair.first, hash);
+		if (slot.second) {
+			ConstructAt(slot.first, hash, std::move(p_pair));
+		}
+		else {
+			m_slots[slot.first].second = std::move(p_pair.second);
+		}
+		return iterator(m_ctrl + slot.first, m_slots + slot.first);
+	}
+
+	const _DataType& At(const _KeyType& p_key) const {
+		size_t index = FindIndex(p_key, HashOf(p_key));
+		if (index == kNpos) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return m_slots[index].second;
+	}
+
+	_DataType& operator[](const _KeyType& p_key) {
+		uint64_t hash = HashOf(p_key);
+		std::pair<size_t, bool> slot = FindOrPrepareInsert(p_key, hash);
+		if (slot.second) {
+			ConstructAt(slot.first, hash, p_key, _DataType());
+		}
+		return m_slots[slot.first].second;
+	}
+
+	void Erase(const _KeyType& p_key) {
+		size_t index = FindIndex(p_key, HashOf(p_key));
+		if (index == kNpos) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		EraseIndex(index);
+	}
+
+	iterator Erase(const iterator& p_iter) {
+		if (p_iter == end()) {
+			throw IteratorError("IteratorError: iterator does not point to an element.");
+		}
+		size_t index = p_iter.GetPtr() - m_slots;
+		EraseIndex(index);
+		return iterator(m_ctrl + index + 1, m_slots + index + 1);
+	}
+
+	double MaxLoadFactor() const {
+		return 0.875;
+	}
+
+	void Reserve(int p_num) {
+		if (p_num <= 0) {
+			throw InvalidValueError("InvalidValueError: invalid hash bucket count.");
+		}
+		size_t capacity = NormalizeCapacity(p_num);
+		if (capacity > m_capacity) {
+			Rehash(capacity);
+		}
+	}
+
+	bool Empty() const {
+		return !m_size;
+	}
+
+	int Size() const {
+		return static_cast<int>(m_size);
+	}
+
+	void Clear() {
+		DestroySlots();
+		if (m_capacity) {
+			std::memset(m_ctrl, static_cast<unsigned char>(FlatCtrl::kEmpty), m_capacity);
+		}
+		m_size = 0;
+		m_growth_left = m_capacity - m_capacity / 8;
+	}
+
+	int GetBucketCount() const {
+		return static_cast<int>(m_capacity);
+	}
+
+	double GetLoadFactor() const {
+		return m_capacity ? m_size / static_cast<double>(m_capacity) : 0.;
+	}
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include "Exceptions.h"
+#include "Hash.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+/*
+Хэш-функции FrozenUnorderedMap. Они constexpr, чтобы таблицу можно было построить при компиляции,
+и возвращают 64 бита: из старших берется группа ключей, а все биты вместе с подбором задают слот.
+*/
+template<typename _KeyType, typename = void>
+struct FrozenHash;
+
+template<typename _KeyType>
+struct FrozenHash<_KeyType, typename std::enable_if<std::is_integral<_KeyType>::value || std::is_enum<_KeyType>::value>::type> {
+	constexpr uint64_t operator()(_KeyType p_key) const {
+		return MixHash(static_cast<uint64_t>(p_key) + 0x9e3779b97f4a7c15ULL);
+	}
+};
+
+// FNV-1a по байтам строки с перемешиванием результата.
+template<>
+struct FrozenHash<std::string_view> {
+	constexpr uint64_t operator()(std::string_view p_key) const {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		for (size_t i = 0; i < p_key.size(); i++) {
+			hash ^= static_cast<unsigned char>(p_key[i]);
+			hash *= 0x100000001b3ULL;
+		}
+		return MixHash(hash);
+	}
+};
+
+template<>
+struct FrozenHash<std::string> : FrozenHash<std::string_view> {};
+
+
+/*
+Неизменяемый контейнер с минимальным совершенным хэшированием (схема CHD): _Size пар лежат в массиве из _Size слотов,
+ключи разбиты на группы по хэшу, и для каждой группы при построении подбирается число (pilot), при котором
+все ее ключи попадают в свободные слоты. Поиск - один хэш, чтение pilot группы, одно обращение к слоту и одно сравнение.
+
+Строится один раз из списка пар (makeFrozenUnorderedMap); для литеральных типов ключа и значения построение
+можно выполнить при компиляции (constexpr). Повторяющийся ключ - InvalidValueError (при компиляции - ошибка компиляции).
+Порядок обхода - порядок слотов.
+*/
+template<typename _KeyType, typename _DataType, size_t _Size, typename _Hash = FrozenHash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>>
+class FrozenUnorderedMap {
+	static_assert(_Size > 0, "FrozenUnorderedMap must contain at least one element.");
+public:
+	using PairType = std::pair<const _KeyType, _DataType>;
+	using const_iterator = const PairType*;
+	using iterator = const_iterator;
+
+private:
+	static constexpr size_t kBuckets = _Size / 2 + 1;    // в среднем два ключа в группе
+	static constexpr uint32_t kMaxPilot = 1u << 24;
+
+	struct Layout {
+		std::array<size_t, _Size> m_order;        // номер исходной пары в каждом слоте
+		std::array<uint32_t, kBuckets> m_pilots;
+	};
+
+	std::array<PairType, _Size> m_items;
+	std::array<uint32_t, kBuckets> m_pilots;
+	_Hash m_hash_obj;
+	_KeyEqual m_key_equal;
+
+	static constexpr size_t BucketOf(uint64_t p_hash) {
+		return static_cast<size_t>((p_hash >> 32) % kBuckets);
+	}
+
+	static constexpr size_t SlotOf(uint64_t p_hash, uint32_t p_pilot) {
+		return static_cast<size_t>(MixHash(p_hash ^ (p_pilot * 0xc2b2ae3d27d4eb4fULL)) % _Size);
+	}
+
+	/*
+	Построение: ключи раскладываются по группам (сортировка подсчетом), группы обрабатываются от больших к меньшим,
+	и для каждой перебираются pilot = 0, 1, ..., пока все ее ключи не попадут в разные свободные слоты.
+	Ключи одной группы с одинаковым полным хэшем разделить нельзя: это либо повтор ключа, либо коллизия хэша.
+	*/
+	static constexpr Layout Build(const PairType (&p_items)[_Size]) {
+		_Hash hash_obj{};
+		_KeyEqual key_equal{};
+		std::array<uint64_t, _Size> hashes{};
+		std::array<size_t, kBuckets + 1> starts{};
+		for (size_t i = 0; i < _Size; i++) {
+			hashes[i] = hash_obj(p_items[i].first);
+			starts[BucketOf(hashes[i]) + 1]++;
+		}
+		for (size_t b = 0; b < kBuckets; b++) {
+			starts[b + 1] += starts[b];
+		}
+		std::array<size_t, _Size> members{};
+		std::array<size_t, kBuckets> filled{};
+		for (size_t i = 0; i < _Size; i++) {
+			size_t bucket = BucketOf(hashes[i]);
+			members[starts[bucket] + filled[bucket]++] = i;
+		}
+
+		// Группы по убыванию размера (сортировка подсчетом по размеру).
+		std::array<size_t, _Size + 2> size_starts{};
+		for (size_t b = 0; b < kBuckets; b++) {
+			size_starts[_Size - (starts[b + 1] - starts[b]) + 1]++;
+		}
+		for (size_t s = 0; s <= _Size; s++) {
+			size_starts[s + 1] += size_starts[s];
+		}
+		std::array<size_t, kBuckets> buckets{};
+		for (size_t b = 0; b < kBuckets; b++) {
+			buckets[size_starts[_Size - (starts[b + 1] - starts[b])]++] = b;
+		}
+
+		Layout layout{};
+		std::array<bool, _Size> taken{};
+		for (size_t k = 0; k < kBuckets; k++) {
+			size_t bucket = buckets[k];
+			size_t first = starts[bucket];
+			size_t last = starts[bucket + 1];
+			if (first == last) {
+				break;
+			}
+			for (size_t i = first; i < last; i++) {
+				for (size_t j = i + 1; j < last; j++) {
+					if (hashes[members[i]] == hashes[members[j]]) {
+						if (key_equal(p_items[members[i]].first, p_items[members[j]].first)) {
+							throw InvalidValueError("InvalidValueError: duplicate key in the frozen container.");
+						}
+						throw InvalidValueError("InvalidValueError: hash collision in the frozen container.");
+					}
+				}
+			}
+			for (uint32_t pilot = 0;; pilot++) {
+				if (pilot == kMaxPilot) {
+					throw InvalidValueError("InvalidValueError: failed to build a perfect hash for the keys.");
+				}
+				size_t placed = first;
+				for (; placed < last; placed++) {
+					size_t slot = SlotOf(hashes[members[placed]], pilot);
+					if (taken[slot]) {
+						break;
+					}
+					taken[slot] = true;
+				}
+				if (placed == last) {
+					for (size_t i = first; i < last; i++) {
+						layout.m_order[SlotOf(hashes[members[i]], pilot)] = members[i];
+					}
+					layout.m_pilots[bucket] = pilot;
+					break;
+				}
+				for (size_t i = first; i < placed; i++) {
+					taken[SlotOf(hashes[members[i]], pilot)] = false;
+				}
+			}
+		}
+		return layout;
+	}
+
+	template<size_t... _Index>
+	constexpr FrozenUnorderedMap(const PairType (&p_items)[_Size], const Layout& p_layout, std::index_sequence<_Index...>) :
+		m_items{ { p_items[p_layout.m_order[_Index]]... } }, m_pilots(p_layout.m_pilots), m_hash_obj(), m_key_equal() {}
+
+public:
+	constexpr explicit FrozenUnorderedMap(const PairType (&p_items)[_Size]) :
+		FrozenUnorderedMap(p_items, Build(p_items), std::make_index_sequence<_Size>()) {}
+
+	constexpr const_iterator begin() const {
+		return m_items.data();
+	}
+
+	constexpr const_iterator end() const {
+		return m_items.data() + _Size;
+	}
+
+	constexpr const_iterator cbegin() const {
+		return begin();
+	}
+
+	constexpr const_iterator cend() const {
+		return end();
+	}
+
+	constexpr const_iterator Find(const _KeyType& p_key) const {
+		uint64_t hash = m_hash_obj(p_key);
+		const PairType& item = m_items[SlotOf(hash, m_pilots[BucketOf(hash)])];
+		return m_key_equal(item.first, p_key) ? &item : end();
+	}
+
+	constexpr const _DataType* TryGet(const _KeyType& p_key) const {
+		const_iterator found = Find(p_key);
+		return found != end() ? &found->second : nullptr;
+	}
+
+	constexpr const _DataType& At(const _KeyType& p_key) const {
+		const_iterator found = Find(p_key);
+		if (found == end()) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return found->second;
+	}
+
+	constexpr bool Contains(const _KeyType& p_key) const {
+		return Find(p_key) != end();
+	}
+
+	constexpr bool Empty() const {
+		return false;
+	}
+
+	constexpr int Size() const {
+		return static_cast<int>(_Size);
+	}
+};
+
+
+// Число элементов выводится из списка: makeFrozenUnorderedMap<int, double>({ { 1, 0.5 }, { 7, 2.0 } }).
+template<typename _KeyType, typename _DataType, typename _Hash = FrozenHash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>, size_t _Size>
+constexpr FrozenUnorderedMap<_KeyType, _DataType, _Size, _Hash, _KeyEqual> makeFrozenUnorderedMap(const std::pair<const _KeyType, _DataType> (&p_items)[_Size]) {
+	return FrozenUnorderedMap<_KeyType, _DataType, _Size, _Hash, _KeyEqual>(p_items);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "Intern.h"
+#include "Serialization.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+// Manufacturer and warehouse address take few distinct values, so they are dictionary-encoded: each holds the id
+// of a string in the shared pool and repeated values are stored once. The name is per record and stays a plain string,
+// since the pool never frees its strings.
+struct Goods
+{
+	uint32_t m_id;                       // Код товара
+	std::string m_name;                  // Название
+	InternedString m_manufacturer;       // Производитель
+	InternedString m_warehouse_address;  // Адрес склада
+	double m_weight;                     // Вес
+};
+
+
+// Goods as stored in a file: strings point directly into the mapped bytes.
+struct GoodsView
+{
+	uint32_t m_id;
+	std::string_view m_name;
+	std::string_view m_manufacturer;
+	std::string_view m_warehouse_address;
+	double m_weight;
+};
+
+template<>
+struct Serializer<Goods> {
+	using ViewType = GoodsView;
+
+	static void Write(std::string& p_out, const Goods& p_goods) {
+		FieldWriter(p_out).Add(p_goods.m_id).Add(p_goods.m_name).Add(p_goods.m_manufacturer).Add(p_goods.m_warehouse_address).Add(p_goods.m_weight);
+	}
+
+	static Goods Read(const char* p_data, size_t p_size) {
+		FieldReader reader(p_data, p_size);
+		return { reader.Read<uint32_t>(), reader.Read<std::string>(), reader.Read<InternedString>(), reader.Read<InternedString>(), reader.Read<double>() };
+	}
+
+	static ViewType View(const char* p_data, size_t p_size) {
+		FieldReader reader(p_data, p_size);
+		return { reader.View<uint32_t>(), reader.View<std::string>(), reader.View<InternedString>(), reader.View<InternedString>(), reader.View<double>() };
+	}
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+
+/*
+Перемешивание хэша (финализатор fmix64 из MurmurHash3). std::hash для целых чисел - тождественное отображение,
+поэтому без перемешивания последовательные коды товаров попадали бы в соседние корзины или в одну группу.
+*/
+constexpr uint64_t MixHash(uint64_t p_hash) {
+	p_hash ^= p_hash >> 33;
+	p_hash *= 0xff51afd7ed558ccdULL;
+	p_hash ^= p_hash >> 33;
+	p_hash *= 0xc4ceb9fe1a85ec53ULL;
+	p_hash ^= p_hash >> 33;
+	return p_hash;
+}
+
+
+/*
+Прозрачная хэш-функция для строковых ключей: std::string, std::string_view и const char* хэшируются одинаково,
+поэтому поиск по string_view или литералу не создает временный std::string.
+Используется вместе с std::equal_to<>.
+*/
+struct TransparentStringHash {
+	using is_transparent = void;
+
+	size_t operator()(std::string_view p_key) const {
+		return std::hash<std::string_view>()(p_key);
+	}
+};
+
+
+// Разрешает поиск по ключам другого типа, только если и хэш, и сравнение объявлены прозрачными.
+template<typename _Hash, typename _KeyEqual, typename = void>
+struct IsTransparent : std::false_type {};
+
+template<typename _Hash, typename _KeyEqual>
+struct IsTransparent<_Hash, _KeyEqual, std::void_t<typename _Hash::is_transparent, typename _KeyEqual::is_transparent>> : std::true_type {};
+
+
+/*
+Политики выбора корзины по полному хэшу. Политика хранит то, что зависит от текущего числа корзин,
+и переинициализируется (Reset) после каждого изменения размера массива корзин.
+RoundBuckets приводит желаемое число корзин к допустимому для политики.
+*/
+
+// Число корзин - степень двойки, индекс - младшие биты перемешанного хэша (маска вместо деления).
+class PowerOfTwoBucketPolicy {
+private:
+	size_t m_mask;
+public:
+	PowerOfTwoBucketPolicy() : m_mask(0) {}
+
+	static int RoundBuckets(int p_buckets) {
+		int buckets = 8;
+		while (buckets < p_buckets && buckets < (1 << 30)) {
+			buckets *= 2;
+		}
+		return buckets;
+	}
+
+	void Reset(int p_buckets) {
+		m_mask = static_cast<size_t>(p_buckets) - 1;
+	}
+
+	int Index(size_t p_hash) const {
+		return static_cast<int>(MixHash(p_hash) & m_mask);
+	}
+};
+
+
+// Любое число корзин; индекс - старшие 32 бита произведения перемешанного хэша на число корзин (fastrange).
+class FastRangeBucketPolicy {
+private:
+	uint64_t m_buckets;
+public:
+	FastRangeBucketPolicy() : m_buckets(0) {}
+
+	static int RoundBuckets(int p_buckets) {
+		return p_buckets < 8 ? 8 : p_buckets;
+	}
+
+	void Reset(int p_buckets) {
+		m_buckets = static_cast<uint64_t>(p_buckets);
+	}
+
+	int Index(size_t p_hash) const {
+		return static_cast<int>(((MixHash(p_hash) >> 32) * m_buckets) >> 32);
+	}
+};
+
+
+// Число корзин - простое, индекс - остаток от деления исходного хэша.
+class PrimeBucketPolicy {
+private:
+	size_t m_prime;
+
+	static const int* Primes(int& p_count) {
+		static const int primes[] = {
+			11, 17, 37, 67, 131, 257, 521, 1031, 2053, 4099, 8209, 16411, 32771, 65537, 131101, 262147, 524309,
+			1048583, 2097169, 4194319, 8388617, 16777259, 33554467, 67108879, 134217757, 268435459, 536870923,
+			1073741827, 2147483647
+		};
+		p_count = sizeof(primes) / sizeof(primes[0]);
+		return primes;
+	}
+public:
+	PrimeBucketPolicy() : m_prime(1) {}
+
+	static int RoundBuckets(int p_buckets) {
+		int count;
+		const int* primes = Primes(count);
+		for (int i = 0; i < count - 1; i++) {
+			if (primes[i] >= p_buckets) {
+				return primes[i];
+			}
+		}
+		return primes[count - 1];
+	}
+
+	void Reset(int p_buckets) {
+		m_prime = static_cast<size_t>(p_buckets);
+	}
+
+	int Index(size_t p_hash) const {
+		return static_cast<int>(p_hash % m_prime);
+	}
+};
@@ -0,0 +1,403 @@
+#pragma once
+#include "Container.h"
+#include "Exceptions.h"
+#include <functional>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/*
+Вторичный индекс IndexedUnorderedMap по проекции значения (_Proj(const _DataType&)). Индекс хранит итераторы
+основного контейнера: узлы UnorderedMap не перемещаются при перехэшировании, поэтому итераторы остаются
+действительными, пока элемент не удален. Add и Remove вызывает только IndexedUnorderedMap.
+*/
+template<typename _KeyType, typename _DataType>
+class SecondaryIndex {
+public:
+	using const_iterator = UnorderedMapIterator<_KeyType, _DataType, true>;
+
+	virtual ~SecondaryIndex() {}
+
+	virtual void Add(const_iterator p_iter) = 0;
+	virtual void Remove(const_iterator p_iter) = 0;
+	virtual void Clear() = 0;
+};
+
+
+// Упорядоченный индекс: запросы по диапазону и по значению за O(log n + k).
+template<typename _KeyType, typename _DataType, typename _Proj, typename _Compare = std::less<>>
+class OrderedIndex : public SecondaryIndex<_KeyType, _DataType> {
+public:
+	using const_iterator = typename SecondaryIndex<_KeyType, _DataType>::const_iterator;
+	using ValueType = typename std::decay<decltype(std::declval<_Proj&>()(std::declval<const _DataType&>()))>::type;
+
+private:
+	struct Entry {
+		ValueType m_value;
+		const_iterator m_iter;
+	};
+
+	// Равные значения упорядочены по адресу узла, чтобы удаление находило ровно свою запись.
+	struct EntryLess {
+		using is_transparent = void;
+
+		_Compare m_comp;
+
+		bool operator()(const Entry& p_left, const Entry& p_right) const {
+			if (m_comp(p_left.m_value, p_right.m_value)) {
+				return true;
+			}
+			if (m_comp(p_right.m_value, p_left.m_value)) {
+				return false;
+			}
+			return std::less<const void*>()(p_left.m_iter.GetPtr(), p_right.m_iter.GetPtr());
+		}
+
+		bool operator()(const Entry& p_left, const ValueType& p_right) const {
+			return m_comp(p_left.m_value, p_right);
+		}
+
+		bool operator()(const ValueType& p_left, const Entry& p_right) const {
+			return m_comp(p_left, p_right.m_value);
+		}
+	};
+
+	_Proj m_proj;
+	std::set<Entry, EntryLess> m_entries;
+
+	template<typename _SetIter>
+	static std::vector<const_iterator> Collect(_SetIter p_first, _SetIter p_last) {
+		std::vector<const_iterator> result;
+		for (; p_first != p_last; ++p_first) {
+			result.push_back(p_first->m_iter);
+		}
+		return result;
+	}
+public:
+	explicit OrderedIndex(_Proj p_proj, _Compare p_comp = _Compare()) : m_proj(p_proj), m_entries(EntryLess{ p_comp }) {}
+
+	void Add(const_iterator p_iter) override {
+		m_entries.insert(Entry{ m_proj(p_iter->second), p_iter });
+	}
+
+	void Remove(const_iterator p_iter) override {
+		m_entries.erase(Entry{ m_proj(p_iter->second), p_iter });
+	}
+
+	void Clear() override {
+		m_entries.clear();
+	}
+
+	// Элементы с проекцией из [p_low, p_high] (включительно) в порядке возрастания проекции.
+	std::vector<const_iterator> Range(const ValueType& p_low, const ValueType& p_high) const {
+		return Collect(m_entries.lower_bound(p_low), m_entries.upper_bound(p_high));
+	}
+
+	// Элементы с проекцией из (p_low, p_high) (без границ) в порядке возрастания проекции.
+	std::vector<const_iterator> RangeOpen(const ValueType& p_low, const ValueType& p_high) const {
+		if (!m_entries.key_comp().m_comp(p_low, p_high)) {
+			return {};
+		}
+		return Collect(m_entries.upper_bound(p_low), m_entries.lower_bound(p_high));
+	}
+
+	std::vector<const_iterator> Equal(const ValueType& p_value) const {
+		auto range = m_entries.equal_range(p_value);
+		return Collect(range.first, range.second);
+	}
+
+	int Size() const {
+		return static_cast<int>(m_entries.size());
+	}
+};
+
+
+// Хэш-индекс: запросы по равенству проекции за O(1 + k); каждая группа равных значений - отдельная хэш-таблица узлов.
+template<typename _KeyType, typename _DataType, typename _Proj, typename _Hash = void>
+class HashIndex : public SecondaryIndex<_KeyType, _DataType> {
+public:
+	using const_iterator = typename SecondaryIndex<_KeyType, _DataType>::const_iterator;
+	using ValueType = typename std::decay<decltype(std::declval<_Proj&>()(std::declval<const _DataType&>()))>::type;
+
+private:
+	using HashType = typename std::conditional<std::is_void<_Hash>::value, std::hash<ValueType>, _Hash>::type;
+	using GroupType = UnorderedMap<const void*, const_iterator>;
+
+	_Proj m_proj;
+	UnorderedMap<ValueType, GroupType, HashType> m_groups;
+public:
+	explicit HashIndex(_Proj p_proj) : m_proj(p_proj) {}
+
+	void Add(const_iterator p_iter) override {
+		m_groups[m_proj(p_iter->second)].Insert({ p_iter.GetPtr(), p_iter });
+	}
+
+	void Remove(const_iterator p_iter) override {
+		auto group = m_groups.Find(m_proj(p_iter->second));
+		if (group == m_groups.end()) {
+			return;
+		}
+		group->second.Erase(p_iter.GetPtr());
+		if (group->second.Empty()) {
+			m_groups.Erase(group);
+		}
+	}
+
+	void Clear() override {
+		m_groups.Clear();
+	}
+
+	std::vector<const_iterator> Equal(const ValueType& p_value) const {
+		std::vector<const_iterator> result;
+		auto group = m_groups.Find(p_value);
+		if (group != m_groups.end()) {
+			result.reserve(group->second.Size());
+			for (auto iter = group->second.cbegin(); iter != group->second.cend(); ++iter) {
+				result.push_back(iter->second);
+			}
+		}
+		return result;
+	}
+
+	int Count(const ValueType& p_value) const {
+		auto group = m_groups.Find(p_value);
+		return group == m_groups.end() ? 0 : group->second.Size();
+	}
+};
+
+
+/*
+UnorderedMap с вторичными индексами по значениям. Все изменения идут через Insert, operator[], Update и Erase,
+которые обновляют индексы; наружу элементы доступны только для чтения (const_iterator), иначе изменение
+значения в обход контейнера рассогласовало бы индексы. Если при вставке или изменении какой-то индекс бросает
+исключение, элемент удаляется из контейнера и всех индексов.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>,
+	typename _BucketPolicy = PowerOfTwoBucketPolicy>
+class IndexedUnorderedMap {
+private:
+	using PairType = std::pair<const _KeyType, _DataType>;
+	using MapType = UnorderedMap<_KeyType, _DataType, _Hash, _KeyEqual, _BucketPolicy>;
+	using IndexType = SecondaryIndex<_KeyType, _DataType>;
+public:
+	using const_iterator = typename MapType::const_iterator;
+
+private:
+	MapType m_map;
+	std::vector<std::unique_ptr<IndexType>> m_indexes;
+
+	// Если какой-то индекс бросает исключение, элемент убирается из уже пройденных индексов.
+	void AddToIndexes(const_iterator p_iter) {
+		size_t added = 0;
+		try {
+			for (; added < m_indexes.size(); added++) {
+				m_indexes[added]->Add(p_iter);
+			}
+		}
+		catch (...) {
+			while (added > 0) {
+				m_indexes[--added]->Remove(p_iter);
+			}
+			throw;
+		}
+	}
+
+	// Элемент, который не удалось добавить во все индексы, удаляется и из контейнера, чтобы индексы не рассогласовались.
+	void AddToIndexesOrErase(typename MapType::iterator p_iter) {
+		try {
+			AddToIndexes(p_iter);
+		}
+		catch (...) {
+			m_map.Erase(p_iter);
+			throw;
+		}
+	}
+
+	void RemoveFromIndexes(const_iterator p_iter) {
+		for (auto& index : m_indexes) {
+			index->Remove(p_iter);
+		}
+	}
+
+	// Изменяет значение существующего элемента: индексы обновляются по старой и новой проекциям.
+	template<typename _Func>
+	void Modify(typename MapType::iterator p_iter, _Func p_func) {
+		RemoveFromIndexes(p_iter);
+		try {
+			p_func(p_iter->second);
+		}
+		catch (...) {
+			AddToIndexesOrErase(p_iter);
+			throw;
+		}
+		AddToIndexesOrErase(p_iter);
+	}
+
+	template<typename _Pair>
+	const_iterator InsertImpl(_Pair&& p_pair) {
+		auto iter = m_map.Find(p_pair.first);
+		if (iter != m_map.end()) {
+			Modify(iter, [&p_pair](_DataType& p_value) { p_value = std::forward<_Pair>(p_pair).second; });
+			return iter;
+		}
+		iter = m_map.Insert(std::forward<_Pair>(p_pair));
+		AddToIndexesOrErase(iter);
+		return iter;
+	}
+
+	template<typename _Index>
+	_Index& AttachIndex(std::unique_ptr<_Index> p_index) {
+		for (auto iter = m_map.cbegin(); iter != m_map.cend(); ++iter) {
+			p_index->Add(iter);
+		}
+		_Index& index = *p_index;
+		m_indexes.push_back(std::move(p_index));
+		return index;
+	}
+
+public:
+	// Результат operator[]: чтение значения и присваивание, которое обновляет индексы.
+	class ValueRef {
+	private:
+		IndexedUnorderedMap* m_owner;
+		typename MapType::iterator m_iter;
+	public:
+		ValueRef(IndexedUnorderedMap* p_owner, typename MapType::iterator p_iter) : m_owner(p_owner), m_iter(p_iter) {}
+
+		operator const _DataType&() const {
+			return m_iter->second;
+		}
+
+		const _DataType& Get() const {
+			return m_iter->second;
+		}
+
+		ValueRef& operator=(const _DataType& p_value) {
+			m_owner->Modify(m_iter, [&p_value](_DataType& p_data) { p_data = p_value; });
+			return *this;
+		}
+
+		ValueRef& operator=(_DataType&& p_value) {
+			m_owner->Modify(m_iter, [&p_value](_DataType& p_data) { p_data = std::move(p_value); });
+			return *this;
+		}
+	};
+
+	IndexedUnorderedMap() {}
+
+	IndexedUnorderedMap(const std::initializer_list<PairType>& p_list) {
+		m_map.InsertRange(p_list.begin(), p_list.end());
+	}
+
+	// Индексы хранят итераторы этого контейнера, поэтому копирование запрещено; перемещение узлы не трогает.
+	IndexedUnorderedMap(const IndexedUnorderedMap&) = delete;
+	IndexedUnorderedMap& operator=(const IndexedUnorderedMap&) = delete;
+	IndexedUnorderedMap(IndexedUnorderedMap&&) = default;
+	IndexedUnorderedMap& operator=(IndexedUnorderedMap&&) = default;
+
+	// Индексы строятся по уже имеющимся элементам; ссылка действительна, пока существует контейнер.
+	template<typename _Proj, typename _Compare = std::less<>>
+	OrderedIndex<_KeyType, _DataType, _Proj, _Compare>& AddOrderedIndex(_Proj p_proj, _Compare p_comp = _Compare()) {
+		return AttachIndex(std::make_unique<OrderedIndex<_KeyType, _DataType, _Proj, _Compare>>(p_proj, p_comp));
+	}
+
+	template<typename _Proj>
+	HashIndex<_KeyType, _DataType, _Proj>& AddHashIndex(_Proj p_proj) {
+		return AttachIndex(std::make_unique<HashIndex<_KeyType, _DataType, _Proj>>(p_proj));
+	}
+
+	const_iterator begin() const {
+		return m_map.begin();
+	}
+
+	const_iterator end() const {
+		return m_map.end();
+	}
+
+	const_iterator cbegin() const {
+		return m_map.cbegin();
+	}
+
+	const_iterator cend() const {
+		return m_map.cend();
+	}
+
+	// Вставляет пару или заменяет значение существующего ключа.
+	const_iterator Insert(const PairType& p_pair) {
+		return InsertImpl(p_pair);
+	}
+
+	const_iterator Insert(PairType&& p_pair) {
+		return InsertImpl(std::move(p_pair));
+	}
+
+	ValueRef operator[](const _KeyType& p_key) {
+		auto result = m_map.TryEmplace(p_key);
+		if (result.second) {
+			AddToIndexesOrErase(result.first);
+		}
+		return ValueRef(this, result.first);
+	}
+
+	// Вызывает p_func(_DataType&) для значения по ключу p_key и обновляет индексы.
+	template<typename _Func>
+	void Update(const _KeyType& p_key, _Func p_func) {
+		auto iter = m_map.Find(p_key);
+		if (iter == m_map.end()) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		Modify(iter, p_func);
+	}
+
+	void Erase(const _KeyType& p_key) {
+		auto iter = m_map.Find(p_key);
+		if (iter == m_map.end()) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		RemoveFromIndexes(iter);
+		m_map.Erase(iter);
+	}
+
+	const_iterator Erase(const_iterator p_iter) {
+		if (p_iter == end()) {
+			throw IteratorError("IteratorError: iterator does not point to an element.");
+		}
+		typename MapType::iterator iter(const_cast<Node<_KeyType, _DataType>*>(p_iter.GetPtr()));
+		RemoveFromIndexes(iter);
+		return m_map.Erase(iter);
+	}
+
+	void Clear() {
+		for (auto& index : m_indexes) {
+			index->Clear();
+		}
+		m_map.Clear();
+	}
+
+	const_iterator Find(const _KeyType& p_key) const {
+		return m_map.Find(p_key);
+	}
+
+	const _DataType& At(const _KeyType& p_key) const {
+		return m_map.At(p_key);
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		return m_map.Contains(p_key);
+	}
+
+	int Size() const {
+		return m_map.Size();
+	}
+
+	bool Empty() const {
+		return m_map.Empty();
+	}
+
+	const MapType& GetMap() const {
+		return m_map;
+	}
+};
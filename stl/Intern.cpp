@@ -0,0 +1,52 @@
+#include "Intern.h"
+
+
+StringPool::StringPool() : m_size(0) {
+	for (int i = 0; i < kMaxChunks; i++) {
+		m_chunks[i].store(nullptr, std::memory_order_relaxed);
+	}
+	Intern("");
+}
+
+StringPool::~StringPool() {
+	for (int i = 0; i < kMaxChunks; i++) {
+		delete[] m_chunks[i].load(std::memory_order_relaxed);
+	}
+}
+
+uint32_t StringPool::Intern(std::string_view p_str) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const uint32_t* found = m_index.TryGet(p_str);
+	if (found) {
+		return *found;
+	}
+	uint32_t id = m_size.load(std::memory_order_relaxed);
+	if (id == ChunkStart(kMaxChunks)) {
+		throw InvalidValueError("InvalidValueError: string pool is full.");
+	}
+	int chunk = ChunkOf(id);
+	std::string* strings = m_chunks[chunk].load(std::memory_order_relaxed);
+	if (!strings) {
+		strings = new std::string[static_cast<size_t>(kFirstChunk) << chunk];
+		m_chunks[chunk].store(strings, std::memory_order_release);
+	}
+	std::string& str = strings[id - ChunkStart(chunk)];
+	str.assign(p_str.data(), p_str.size());
+	m_index.Insert({ std::string_view(str), id });
+	m_size.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+std::optional<uint32_t> StringPool::Find(std::string_view p_str) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const uint32_t* found = m_index.TryGet(p_str);
+	if (!found) {
+		return std::nullopt;
+	}
+	return *found;
+}
+
+StringPool& StringPool::Default() {
+	static StringPool pool;
+	return pool;
+}
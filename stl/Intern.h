@@ -0,0 +1,142 @@
+#pragma once
+#include "Container.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/*
+Пул строк: каждая различная строка хранится один раз и получает номер (id), который не меняется
+до разрушения пула. Номер 0 всегда означает пустую строку.
+Строки лежат в кусках удваивающегося размера, которые никогда не перемещаются, поэтому Get не берет блокировок
+и ссылки на строки остаются действительными. Intern и Find сериализуются мьютексом.
+*/
+class StringPool {
+private:
+	static constexpr uint32_t kFirstChunk = 64;
+	static constexpr int kMaxChunks = 26;        // всего kFirstChunk * (2^26 - 1) = 2^32 - 64 номеров
+
+	std::atomic<std::string*> m_chunks[kMaxChunks];
+	std::atomic<uint32_t> m_size;
+	UnorderedMap<std::string_view, uint32_t> m_index;   // ключи указывают на строки самого пула
+	mutable std::mutex m_mutex;
+
+	// Кусок c содержит номера [kFirstChunk * (2^c - 1), kFirstChunk * (2^(c+1) - 1)).
+	static int ChunkOf(uint32_t p_id) {
+		uint32_t n = p_id / kFirstChunk + 1;
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, n);
+		return static_cast<int>(index);
+#else
+		return 31 - __builtin_clz(n);
+#endif
+	}
+
+	static uint32_t ChunkStart(int p_chunk) {
+		return kFirstChunk * ((1u << p_chunk) - 1);
+	}
+public:
+	StringPool();
+	StringPool(const StringPool&) = delete;
+	StringPool& operator=(const StringPool&) = delete;
+	~StringPool();
+
+	// Номер строки p_str; если ее еще нет в пуле, она добавляется.
+	uint32_t Intern(std::string_view p_str);
+
+	// Номер строки без добавления: если строки нет в пуле, ни одна запись не может быть ей равна.
+	std::optional<uint32_t> Find(std::string_view p_str) const;
+
+	const std::string& Get(uint32_t p_id) const {
+		if (p_id >= m_size.load(std::memory_order_acquire)) {
+			throw ItemNotFoundError("ItemNotFoundError: string with such id is not present in the pool.");
+		}
+		int chunk = ChunkOf(p_id);
+		return m_chunks[chunk].load(std::memory_order_acquire)[p_id - ChunkStart(chunk)];
+	}
+
+	int Size() const {
+		return static_cast<int>(m_size.load(std::memory_order_acquire));
+	}
+
+	// Общий пул процесса, которым пользуется InternedString.
+	static StringPool& Default();
+};
+
+
+/*
+Строка из StringPool::Default(), представленная номером (4 байта). Сравнение и хэширование идут по номеру,
+без обращения к символам; равные строки всегда имеют равные номера. Номер имеет смысл только в этом процессе,
+поэтому при сериализации записывается сама строка.
+*/
+class InternedString {
+private:
+	uint32_t m_id;
+public:
+	InternedString() : m_id(0) {}
+
+	InternedString(std::string_view p_str) : m_id(StringPool::Default().Intern(p_str)) {}
+
+	InternedString(const std::string& p_str) : InternedString(std::string_view(p_str)) {}
+
+	InternedString(const char* p_str) : InternedString(std::string_view(p_str)) {}
+
+	// Строка по номеру, полученному из GetId или StringPool::Default().Intern.
+	static InternedString FromId(uint32_t p_id) {
+		InternedString str;
+		str.m_id = p_id;
+		return str;
+	}
+
+	// Уже интернированная строка p_str; в отличие от конструктора не добавляет строку в пул.
+	static std::optional<InternedString> Find(std::string_view p_str) {
+		std::optional<uint32_t> id = StringPool::Default().Find(p_str);
+		if (!id) {
+			return std::nullopt;
+		}
+		return FromId(*id);
+	}
+
+	uint32_t GetId() const {
+		return m_id;
+	}
+
+	const std::string& Str() const {
+		return StringPool::Default().Get(m_id);
+	}
+
+	bool Empty() const {
+		return m_id == 0;
+	}
+
+	bool operator==(const InternedString& p_other) const {
+		return m_id == p_other.m_id;
+	}
+
+	bool operator!=(const InternedString& p_other) const {
+		return m_id != p_other.m_id;
+	}
+};
+
+inline std::ostream& operator<<(std::ostream& p_stream, const InternedString& p_str) {
+	return p_stream << p_str.Str();
+}
+
+namespace std {
+	template<>
+	struct hash<InternedString> {
+		size_t operator()(const InternedString& p_str) const {
+			return p_str.GetId();
+		}
+	};
+}
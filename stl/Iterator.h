@@ -1,84 +1,203 @@
 #pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+
+/*
+Проверки итераторов (разыменование и сдвиг итератора, не указывающего на элемент, бросают IteratorError).
+По умолчанию включены в отладочной сборке и выключены при NDEBUG; можно задать явно, определив STL_CHECKED_ITERATORS в 0 или 1.
+Без проверок во внутренних циклах обхода не остается ни одного лишнего ветвления.
+*/
+#ifndef STL_CHECKED_ITERATORS
+#ifdef NDEBUG
+#define STL_CHECKED_ITERATORS 0
+#else
+#define STL_CHECKED_ITERATORS 1
+#endif
+#endif
 
 
 template<typename _KeyType, typename _DataType>
 class Node;
 
 
-template<typename _KeyType, typename _DataType>
+/*
+Итератор UnorderedMap; при _IsConst = true - const_iterator (элементы доступны только для чтения).
+Обычный итератор неявно преобразуется в константный.
+*/
+template<typename _KeyType, typename _DataType, bool _IsConst = false>
 class UnorderedMapIterator {
 	using PairType = std::pair<const _KeyType, _DataType>;
 	using NodeType = Node<_KeyType, _DataType>;
+	using NodePtr = typename std::conditional<_IsConst, const NodeType*, NodeType*>::type;
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = PairType;
+	using difference_type = std::ptrdiff_t;
+	using pointer = typename std::conditional<_IsConst, const PairType*, PairType*>::type;
+	using reference = typename std::conditional<_IsConst, const PairType&, PairType&>::type;
 private:
-	NodeType* m_ptr;
+	NodePtr m_ptr;
+
+	void Check() const {
+#if STL_CHECKED_ITERATORS
+		if (!m_ptr) {
+			throw IteratorError("IteratorError: iterator does not point to an element.");
+		}
+#endif
+	}
 public:
-	UnorderedMapIterator(NodeType* p_ptr = nullptr) : m_ptr(p_ptr) {}
+	UnorderedMapIterator(NodePtr p_ptr = nullptr) : m_ptr(p_ptr) {}
 	UnorderedMapIterator(const UnorderedMapIterator& p_other): m_ptr(p_other.m_ptr) {}
 
+	template<bool _OtherConst, typename = typename std::enable_if<_IsConst && !_OtherConst>::type>
+	UnorderedMapIterator(const UnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) : m_ptr(p_other.GetPtr()) {}
+
 	UnorderedMapIterator& operator=(const UnorderedMapIterator& p_other) {
 		if (this == &p_other) {
 			return *this;
-		}	
+		}
 		m_ptr = p_other.m_ptr;
 		return *this;
 	}
 
-	UnorderedMapIterator& operator=(const NodeType* p_ptr) {
+	UnorderedMapIterator& operator=(NodePtr p_ptr) {
 		m_ptr = p_ptr;
 		return *this;
 	}
 
-	const PairType& operator*() const {
-		if (!m_ptr) {
-			throw IteratorError("IteratorError: iterator does not point to an element.");
-		}
+	reference operator*() const {
+		Check();
 		return m_ptr->m_pair;
 	}
 
-	PairType& operator*() {
-		if (!m_ptr) {
-			throw IteratorError("IteratorError: iterator does not point to an element.");
-		}
-		return m_ptr->m_pair;	
+	pointer operator->() const {
+		Check();
+		return &(m_ptr->m_pair);
 	}
 
 	UnorderedMapIterator& operator++() {
-		if (!m_ptr) {
-			throw IteratorError("IteratorError: iterator does not point to an element.");
-		}
+		Check();
 		m_ptr = m_ptr->m_next;
 		return *this;
 	}
 
 	UnorderedMapIterator operator++(int) {
-		if (!m_ptr) {
-			throw IteratorError("IteratorError: iterator does not point to an element.");
-		}
+		Check();
 		UnorderedMapIterator temp(*this);
 		m_ptr = m_ptr->m_next;
 		return temp;
 	}
 
-	bool operator==(const UnorderedMapIterator& p_other) const {
-		return m_ptr == p_other.m_ptr;
+	template<bool _OtherConst>
+	bool operator==(const UnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) const {
+		return m_ptr == p_other.GetPtr();
 	}
 
-	bool operator!=(const UnorderedMapIterator& p_other) const {
+	template<bool _OtherConst>
+	bool operator!=(const UnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) const {
 		return !operator==(p_other);
 	}
 
-	PairType* operator->() {
+	int GetBucketNumber() const {
 		if (!m_ptr) {
 			throw IteratorError("IteratorError: iterator does not point to an element.");
 		}
-		return &(m_ptr->m_pair);
+		return m_ptr->m_bucket_number;
 	}
-	
-	int GetBucketNumber() const {
+
+	NodePtr GetPtr() const {
+		return m_ptr;
+	}
+};
+
+
+/*
+Итератор по диапазону корзин [p_first, p_last) одного массива корзин UnorderedMap. Цепочка корзины - непрерывный
+участок общего списка, начинающийся с m_table[b], поэтому обход идет от головы каждой корзины до первого узла
+чужой корзины, без прохода по остальному списку. p_parity - четность номеров корзин этого массива.
+*/
+template<typename _KeyType, typename _DataType>
+class UnorderedMapBucketIterator {
+	using PairType = std::pair<const _KeyType, _DataType>;
+	using NodeType = Node<_KeyType, _DataType>;
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = PairType;
+	using difference_type = std::ptrdiff_t;
+	using pointer = PairType*;
+	using reference = PairType&;
+private:
+	NodeType* const* m_table;
+	int m_bucket;
+	int m_last;
+	int m_parity;
+	NodeType* m_ptr;
+
+	void Check() const {
+#if STL_CHECKED_ITERATORS
 		if (!m_ptr) {
 			throw IteratorError("IteratorError: iterator does not point to an element.");
 		}
-		return m_ptr->m_bucket_number;
+#endif
+	}
+
+	void SkipEmptyBuckets() {
+		while (m_bucket < m_last && !m_table[m_bucket]) {
+			m_bucket++;
+		}
+		m_ptr = m_bucket < m_last ? m_table[m_bucket] : nullptr;
+	}
+public:
+	UnorderedMapBucketIterator() : m_table(nullptr), m_bucket(0), m_last(0), m_parity(0), m_ptr(nullptr) {}
+
+	UnorderedMapBucketIterator(NodeType* const* p_table, int p_first, int p_last, int p_parity) : m_table(p_table), m_bucket(p_first),
+		m_last(p_last), m_parity(p_parity) {
+		SkipEmptyBuckets();
+	}
+
+	PairType& operator*() const {
+		Check();
+		return m_ptr->m_pair;
+	}
+
+	PairType* operator->() const {
+		Check();
+		return &(m_ptr->m_pair);
+	}
+
+	UnorderedMapBucketIterator& operator++() {
+		Check();
+		NodeType* next_ptr = m_ptr->m_next;
+		if (next_ptr && next_ptr->m_bucket_number == 2 * m_bucket + m_parity) {
+			m_ptr = next_ptr;
+		}
+		else {
+			m_bucket++;
+			SkipEmptyBuckets();
+		}
+		return *this;
+	}
+
+	UnorderedMapBucketIterator operator++(int) {
+		UnorderedMapBucketIterator temp(*this);
+		operator++();
+		return temp;
+	}
+
+	bool operator==(const UnorderedMapBucketIterator& p_other) const {
+		return m_ptr == p_other.m_ptr;
+	}
+
+	bool operator!=(const UnorderedMapBucketIterator& p_other) const {
+		return !operator==(p_other);
+	}
+
+	// Тот же элемент как обычный итератор контейнера.
+	operator UnorderedMapIterator<_KeyType, _DataType>() const {
+		return UnorderedMapIterator<_KeyType, _DataType>(m_ptr);
 	}
 
 	NodeType* GetPtr() const {
@@ -86,3 +205,133 @@ public:
 	}
 };
 
+
+// Часть контейнера из подряд идущих корзин; результат UnorderedMap::Split.
+template<typename _KeyType, typename _DataType>
+class UnorderedMapBucketRange {
+	using NodeType = Node<_KeyType, _DataType>;
+	using iterator = UnorderedMapBucketIterator<_KeyType, _DataType>;
+private:
+	NodeType* const* m_table;
+	int m_first;
+	int m_last;
+	int m_parity;
+public:
+	UnorderedMapBucketRange(NodeType* const* p_table, int p_first, int p_last, int p_parity) : m_table(p_table), m_first(p_first),
+		m_last(p_last), m_parity(p_parity) {}
+
+	iterator begin() const {
+		return iterator(m_table, m_first, m_last, m_parity);
+	}
+
+	iterator end() const {
+		return iterator();
+	}
+
+	int GetFirstBucket() const {
+		return m_first;
+	}
+
+	int GetLastBucket() const {
+		return m_last;
+	}
+};
+
+
+
+/*
+Управляющие байты открытой адресации FlatUnorderedMap: неотрицательный байт - занятый слот
+(в нем хранятся 7 младших бит хэша), отрицательные - служебные состояния.
+*/
+struct FlatCtrl {
+	static constexpr signed char kEmpty = -128;
+	static constexpr signed char kDeleted = -2;
+	static constexpr signed char kSentinel = -1;
+};
+
+
+template<typename _KeyType, typename _DataType, bool _IsConst = false>
+class FlatUnorderedMapIterator {
+	using PairType = std::pair<const _KeyType, _DataType>;
+	using SlotPtr = typename std::conditional<_IsConst, const PairType*, PairType*>::type;
+public:
+	using iterator_category = std::forward_iterator_tag;
+	using value_type = PairType;
+	using difference_type = std::ptrdiff_t;
+	using pointer = SlotPtr;
+	using reference = typename std::conditional<_IsConst, const PairType&, PairType&>::type;
+private:
+	const signed char* m_ctrl;
+	SlotPtr m_slot;
+
+	void Check() const {
+#if STL_CHECKED_ITERATORS
+		if (!m_slot) {
+			throw IteratorError("IteratorError: iterator does not point to an element.");
+		}
+#endif
+	}
+
+	void SkipEmptySlots() {
+		while (*m_ctrl < 0 && *m_ctrl != FlatCtrl::kSentinel) {
+			++m_ctrl;
+			++m_slot;
+		}
+		if (*m_ctrl == FlatCtrl::kSentinel) {
+			m_ctrl = nullptr;
+			m_slot = nullptr;
+		}
+	}
+public:
+	FlatUnorderedMapIterator(const signed char* p_ctrl = nullptr, SlotPtr p_slot = nullptr) : m_ctrl(p_ctrl), m_slot(p_slot) {
+		if (m_ctrl) {
+			SkipEmptySlots();
+		}
+	}
+
+	template<bool _OtherConst, typename = typename std::enable_if<_IsConst && !_OtherConst>::type>
+	FlatUnorderedMapIterator(const FlatUnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) : m_ctrl(p_other.GetCtrl()),
+		m_slot(p_other.GetPtr()) {}
+
+	reference operator*() const {
+		Check();
+		return *m_slot;
+	}
+
+	pointer operator->() const {
+		Check();
+		return m_slot;
+	}
+
+	FlatUnorderedMapIterator& operator++() {
+		Check();
+		++m_ctrl;
+		++m_slot;
+		SkipEmptySlots();
+		return *this;
+	}
+
+	FlatUnorderedMapIterator operator++(int) {
+		FlatUnorderedMapIterator temp(*this);
+		operator++();
+		return temp;
+	}
+
+	template<bool _OtherConst>
+	bool operator==(const FlatUnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) const {
+		return m_slot == p_other.GetPtr();
+	}
+
+	template<bool _OtherConst>
+	bool operator!=(const FlatUnorderedMapIterator<_KeyType, _DataType, _OtherConst>& p_other) const {
+		return !operator==(p_other);
+	}
+
+	SlotPtr GetPtr() const {
+		return m_slot;
+	}
+
+	const signed char* GetCtrl() const {
+		return m_ctrl;
+	}
+};
@@ -1,25 +1,32 @@
 #pragma once
 #include "Exceptions.h"
 #include "Iterator.h"
+#include "NodePool.h"
 #include <functional>
 #include <iostream>
 #include <iomanip>
+#include <memory_resource>
+#include <type_traits>
 
 
 template<typename _KeyType, typename _DataType>
 class Node {
 	using PairType = std::pair<const _KeyType, _DataType>;
 public:
-	Node(PairType p_pair, int p_bucket_number, Node* p_prev = nullptr, Node* p_next = nullptr) : m_pair(p_pair), m_bucket_number(p_bucket_number), m_prev(p_prev), m_next(p_next) {}
+	// Пара конструируется на месте из p_args (в том числе через std::piecewise_construct), без промежуточной копии.
+	template<typename... _Args>
+	explicit Node(size_t p_hash, int p_bucket_number, _Args&&... p_args) : m_pair(std::forward<_Args>(p_args)...), m_next(nullptr), m_prev(nullptr),
+		m_hash(p_hash), m_bucket_number(p_bucket_number) {}
 	PairType m_pair;
 	Node* m_next;
 	Node* m_prev;
+	size_t m_hash;           // полный хэш ключа: перехэширование не вызывает хэш-функцию, а сравнение ключей идет только при совпадении хэшей
 	int m_bucket_number;
 };
 
 
 /*
-  ,     _KeyType  _DataType
+Класс двусвязного списка, хранящего пары объектов типов _KeyType и _DataType
 */
 template <typename _KeyType, typename _DataType, typename _Hash>
 class Chain {
@@ -29,10 +36,28 @@ class Chain {
 private:
 	NodeType* m_head;
 	int m_size;
+	NodePool<NodeType> m_pool;   // память под узлы; все узлы списка принадлежат этому пулу
+
+	template<typename... _Args>
+	NodeType* CreateNode(_Args&&... p_args) {
+		void* memory = m_pool.Allocate();
+		try {
+			return new (memory) NodeType(std::forward<_Args>(p_args)...);
+		}
+		catch (...) {
+			m_pool.Deallocate(memory);
+			throw;
+		}
+	}
+
+	void DestroyNode(NodeType* p_node) {
+		p_node->~NodeType();
+		m_pool.Deallocate(p_node);
+	}
 public:
-	Chain() : m_head(nullptr), m_size(0) {}
+	explicit Chain(std::pmr::memory_resource* p_resource = std::pmr::get_default_resource()) : m_head(nullptr), m_size(0), m_pool(p_resource) {}
 
-	Chain(Chain&& p_other): m_head(p_other.m_head), m_size(p_other.m_size) {
+	Chain(Chain&& p_other) noexcept : m_head(p_other.m_head), m_size(p_other.m_size), m_pool(std::move(p_other.m_pool)) {
 		p_other.m_size = 0;
 		p_other.m_head = nullptr;
 	}
@@ -41,159 +66,166 @@ public:
 		Clear();
 	}
 
-	Chain& operator=(Chain&& p_other) {
+	Chain& operator=(Chain&& p_other) noexcept {
 		if (this == &p_other) {
 			return *this;
 		}
 		Clear();
 		m_head = p_other.m_head;
 		m_size = p_other.m_size;
+		m_pool = std::move(p_other.m_pool);
 		p_other.m_head = nullptr;
 		p_other.m_size = 0;
 		return *this;
 	}
 
-	iterator Insert(const PairType& p_pair, NodeType*& p_node_ptr, int p_bucket_number) {
-		if (p_node_ptr) {
-			NodeType* cur_ptr = p_node_ptr;
-			NodeType* prev_ptr = nullptr;
-			while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
-				if (cur_ptr->m_pair.first == p_pair.first) {
-					cur_ptr->m_pair.second = p_pair.second;
-					return iterator(cur_ptr);
-				}
-				prev_ptr = cur_ptr;
-				cur_ptr = cur_ptr->m_next;
-			}
-			prev_ptr->m_next = new NodeType(p_pair, p_bucket_number, prev_ptr, cur_ptr);
-			if (cur_ptr) {
-				cur_ptr->m_prev = prev_ptr->m_next;
+	// p_key может иметь тип, отличный от _KeyType, если p_equal умеет сравнивать его с ключами.
+	template<typename _Key, typename _KeyEqual>
+	NodeType* Find(NodeType* p_node_ptr, const _Key& p_key, size_t p_hash, int p_bucket_number, const _KeyEqual& p_equal) const {
+		NodeType* cur_ptr = p_node_ptr;
+		while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
+			if (cur_ptr->m_hash == p_hash && p_equal(cur_ptr->m_pair.first, p_key)) {
+				return cur_ptr;
 			}
-			m_size++;
-			return iterator(prev_ptr->m_next);
+			cur_ptr = cur_ptr->m_next;
 		}
-		m_head = new NodeType(p_pair, p_bucket_number, nullptr, m_head);
-		if (m_head->m_next) {
-			m_head->m_next->m_prev = m_head;
-		}
-		p_node_ptr = m_head;
-		m_size++;
-		return iterator(m_head);
+		return nullptr;
 	}
 
-	const _DataType& At(NodeType* p_node_ptr, const _KeyType& p_key, int p_bucket_number) const {
-		if (p_node_ptr) {
-			NodeType* cur_ptr = p_node_ptr;
-			while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
-				if (cur_ptr->m_pair.first == p_key) {
-					return cur_ptr->m_pair.second;
-				}
-				cur_ptr = cur_ptr->m_next;
-			}
-		}
-		throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
-	}
-
-	_DataType& GetReferenceToElement(NodeType* p_node_ptr,const _KeyType& p_key, int p_bucket_number) {
-		if (p_node_ptr) {
-			NodeType* cur_ptr = p_node_ptr;
-			NodeType* prev_ptr = nullptr;
-			while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
-				if (cur_ptr->m_pair.first == p_key) {
-					return cur_ptr->m_pair.second;
-				}
-				prev_ptr = cur_ptr;
-				cur_ptr = cur_ptr->m_next;
-			}
-			prev_ptr->m_next = new NodeType(PairType(p_key, _DataType()), p_bucket_number, prev_ptr, cur_ptr);
-			if (cur_ptr) {
-				cur_ptr->m_prev = prev_ptr->m_next;
+	// То же, что Find, но прибавляет к p_probes число просмотренных узлов (для STL_MAP_STATS).
+	template<typename _Key, typename _KeyEqual>
+	NodeType* Find(NodeType* p_node_ptr, const _Key& p_key, size_t p_hash, int p_bucket_number, const _KeyEqual& p_equal, int& p_probes) const {
+		NodeType* cur_ptr = p_node_ptr;
+		while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
+			p_probes++;
+			if (cur_ptr->m_hash == p_hash && p_equal(cur_ptr->m_pair.first, p_key)) {
+				return cur_ptr;
 			}
-			m_size++;
-			return prev_ptr->m_next->m_pair.second;
+			cur_ptr = cur_ptr->m_next;
 		}
+		return nullptr;
+	}
 
-		m_head = new NodeType(PairType(p_key, _DataType()), p_bucket_number, nullptr, m_head);
-		if (m_head->m_next) {
-			m_head->m_next->m_prev = m_head;
+	/*
+	Встраивает узел в начало цепочки корзины p_node_ptr; если корзина пуста, ее цепочка начинается с головы списка.
+	Узел не копируется и не выделяется заново - этим пользуется перехэширование.
+	*/
+	void Link(NodeType* p_node, NodeType*& p_node_ptr, int p_bucket_number) {
+		NodeType* next_ptr = p_node_ptr ? p_node_ptr : m_head;
+		NodeType* prev_ptr = next_ptr ? next_ptr->m_prev : nullptr;
+		p_node->m_bucket_number = p_bucket_number;
+		p_node->m_prev = prev_ptr;
+		p_node->m_next = next_ptr;
+		if (prev_ptr) {
+			prev_ptr->m_next = p_node;
 		}
-		p_node_ptr = m_head;
-		m_size++;
-		return m_head->m_pair.second;
-
-	}
-
-	void Erase(NodeType*& p_node_ptr,const _KeyType& p_key, int p_bucket_number) {
-		if (p_node_ptr) {
-			NodeType* cur_ptr = p_node_ptr;
-			while (cur_ptr && cur_ptr->m_bucket_number == p_bucket_number) {
-				if (cur_ptr->m_pair.first == p_key) {
-					NodeType* prev_ptr = cur_ptr->m_prev;
-					NodeType* next_ptr = cur_ptr->m_next;
-					if (cur_ptr == p_node_ptr) {
-						if (next_ptr == nullptr || next_ptr->m_bucket_number != p_bucket_number) {
-							p_node_ptr = nullptr;
-						}
-						else {
-							p_node_ptr = next_ptr;
-						}
-					}
-					if (cur_ptr == m_head) {
-						m_head = m_head->m_next;
-					}
-					if (prev_ptr) {
-						prev_ptr->m_next = next_ptr;
-					}
-					if (next_ptr) {
-						next_ptr->m_prev = prev_ptr;
-					}
-					delete cur_ptr;
-					m_size--;
-					return;
-				}
-				cur_ptr = cur_ptr->m_next;
-			}
+		else {
+			m_head = p_node;
 		}
-		throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		if (next_ptr) {
+			next_ptr->m_prev = p_node;
+		}
+		p_node_ptr = p_node;
 	}
 
-	iterator Erase(const iterator& p_iter, NodeType*& p_node_ptr, int p_bucket_number) {
-		if (p_iter == nullptr) {
-			throw IteratorError("IteratorError: iterator does not point to an element.");
-		}
-		NodeType* node_to_remove = p_iter.GetPtr();
-		NodeType* prev_ptr = node_to_remove->m_prev;
-		NodeType* next_ptr = node_to_remove->m_next;
-		if (node_to_remove == p_node_ptr) {
-			if (next_ptr == nullptr || next_ptr->m_bucket_number != p_bucket_number) {
+	// Исключает узел из списка, не разрушая его; p_node_ptr - начало цепочки его корзины.
+	void Unlink(NodeType* p_node, NodeType*& p_node_ptr) {
+		NodeType* prev_ptr = p_node->m_prev;
+		NodeType* next_ptr = p_node->m_next;
+		if (p_node == p_node_ptr) {
+			if (next_ptr == nullptr || next_ptr->m_bucket_number != p_node->m_bucket_number) {
 				p_node_ptr = nullptr;
 			}
 			else {
 				p_node_ptr = next_ptr;
 			}
 		}
-		if (node_to_remove == m_head) {
-			m_head = m_head->m_next;
-		}
 		if (prev_ptr) {
 			prev_ptr->m_next = next_ptr;
 		}
+		else {
+			m_head = next_ptr;
+		}
 		if (next_ptr) {
 			next_ptr->m_prev = prev_ptr;
 		}
-		delete node_to_remove;
+	}
+
+	// Отдает все узлы списка (по-прежнему связанные через m_next) для перестройки; размер не меняется.
+	NodeType* Detach() {
+		NodeType* head = m_head;
+		m_head = nullptr;
+		return head;
+	}
+
+	template<typename... _Args>
+	NodeType* Emplace(size_t p_hash, NodeType*& p_node_ptr, int p_bucket_number, _Args&&... p_args) {
+		NodeType* node = CreateNode(p_hash, p_bucket_number, std::forward<_Args>(p_args)...);
+		LinkNew(node, p_node_ptr, p_bucket_number);
+		return node;
+	}
+
+	/*
+	Создает узел, еще не включенный в список (хэш и корзина заполняются позже). Нужен, когда ключ становится
+	известен только после конструирования пары; узел затем либо включается LinkNew, либо уничтожается Destroy.
+	*/
+	template<typename... _Args>
+	NodeType* Construct(_Args&&... p_args) {
+		return CreateNode(0, 0, std::forward<_Args>(p_args)...);
+	}
+
+	void LinkNew(NodeType* p_node, NodeType*& p_node_ptr, int p_bucket_number) {
+		Link(p_node, p_node_ptr, p_bucket_number);
+		m_size++;
+	}
+
+	/*
+	Создает узел с заданными хэшем и номером корзины и ставит его в список сразу после p_tail (nullptr - в пустой список).
+	Цепочки корзин не перестраиваются: так копирование контейнера воспроизводит готовый список узел за узлом.
+	*/
+	template<typename... _Args>
+	NodeType* EmplaceAfter(NodeType* p_tail, size_t p_hash, int p_bucket_number, _Args&&... p_args) {
+		NodeType* node = CreateNode(p_hash, p_bucket_number, std::forward<_Args>(p_args)...);
+		node->m_prev = p_tail;
+		if (p_tail) {
+			p_tail->m_next = node;
+		}
+		else {
+			m_head = node;
+		}
+		m_size++;
+		return node;
+	}
+
+	void Destroy(NodeType* p_node) {
+		DestroyNode(p_node);
+	}
+
+	// Следующие p_nodes узлов будут выделены подряд в одном слэбе.
+	void ReserveNodes(int p_nodes) {
+		m_pool.Reserve(static_cast<size_t>(p_nodes));
+	}
+
+	// Возвращает узел, следующий за удаленным.
+	NodeType* Erase(NodeType* p_node, NodeType*& p_node_ptr) {
+		NodeType* next_ptr = p_node->m_next;
+		Unlink(p_node, p_node_ptr);
+		DestroyNode(p_node);
 		m_size--;
-		return iterator(next_ptr);
+		return next_ptr;
 	}
 
+	// Память узлов возвращается целыми слэбами; для тривиально разрушаемых пар обход списка не нужен.
 	void Clear() {
-		NodeType* cur_ptr = m_head;
-		NodeType* next_ptr;
-		while (cur_ptr) {
-			next_ptr = cur_ptr->m_next;
-			delete cur_ptr;
-			cur_ptr = next_ptr;
+		if (!std::is_trivially_destructible<PairType>::value) {
+			NodeType* cur_ptr = m_head;
+			while (cur_ptr) {
+				NodeType* next_ptr = cur_ptr->m_next;
+				cur_ptr->~NodeType();
+				cur_ptr = next_ptr;
+			}
 		}
+		m_pool.Release();
 		m_head = nullptr;
 		m_size = 0;
 	}
@@ -205,5 +237,17 @@ public:
 	NodeType* GetHead() {
 		return m_head;
 	}
+
+	const NodeType* GetHead() const {
+		return m_head;
+	}
+
+	std::pmr::memory_resource* GetResource() const {
+		return m_pool.GetResource();
+	}
+
+	size_t GetAllocatedBytes() const {
+		return m_pool.GetAllocatedBytes();
+	}
 };
 
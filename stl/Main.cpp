@@ -1,18 +1,15 @@
 #include "Algorithms.h"
 #include "Container.h"
+#include "FrozenContainer.h"
+#include "Goods.h"
+#include "Index.h"
+#include "Serialization.h"
+#include <filesystem>
 #include <iostream>
 #include <iomanip>
 
 
-// TASK 1
-struct Goods
-{
-	uint32_t m_id;                    //  
-	std::string m_name;               // 
-	std::string m_manufacturer;       // 
-	std::string m_warehouse_address;  //  
-	double m_weight;                  // 
-};
+// TASK 1 - the Goods structure is declared in Goods.h
 
 
 int main() {
@@ -81,4 +78,41 @@ int main() {
 
 
 	// TASK 7 - not feasible for unordered_map
+
+
+	// Saving cont_1 to a temporary file; the mapped copy is searched without deserializing the elements
+	string path = (filesystem::temp_directory_path() / "goods.bin").string();
+	saveUnorderedMap(cont_1, path);
+	{
+		MappedUnorderedMap<uint32_t, Goods> mapped(path);
+		GoodsView view = mapped.At(54);
+		cout << endl << endl << "Element 54 read from the file 'goods.bin' (" << mapped.Size() << " elements):" << endl;
+		cout << "|  Id: " << setw(5) << view.m_id << "  |  Name: " << setw(10) << view.m_name << "  |  Manufacturer: " << setw(10) << view.m_manufacturer <<
+			"  |  Warehouse address: " << setw(30) << view.m_warehouse_address << "  |  Weight: " << setw(5) << view.m_weight << "  |" << endl;
+	}
+	filesystem::remove(path);
+
+
+	// The same weight query as in TASK 5, answered by a secondary index instead of a full scan
+	IndexedUnorderedMap<uint32_t, Goods> indexed;
+	forEach(cont_1.begin(), cont_1.end(), [&indexed](const PairType& pair) { indexed.Insert(pair); });
+	auto& by_weight = indexed.AddOrderedIndex([](const Goods& goods) { return goods.m_weight; });
+	auto& by_manufacturer = indexed.AddHashIndex([](const Goods& goods) { return goods.m_manufacturer; });
+	cout << endl << "Goods with a mass from 7 to 9 found by the weight index:" << endl;
+	for (auto found : by_weight.RangeOpen(7, 9)) {
+		cout << "|  Id: " << setw(5) << found->first << "  |  Name: " << setw(10) << found->second.m_name << "  |  Weight: " << setw(5) << found->second.m_weight << "  |" << endl;
+	}
+	auto ikea = InternedString::Find("IKEA");    // looked up without adding the string to the pool
+	cout << "Goods manufactured by IKEA: " << (ikea ? by_manufacturer.Count(*ikea) : 0) << endl;
+
+
+	// Bucket statistics of cont_1 (operation counters are filled only when built with STL_MAP_STATS=1)
+	cout << endl << "Statistics of the container cont_1:" << endl << cont_1.GetStats().ToJson() << endl;
+
+
+	// A read-only table built at compile time as a minimal perfect hash: one probe and one comparison per lookup
+	constexpr auto delivery_days = makeFrozenUnorderedMap<std::string_view, int>({
+		{"IKEA", 3}, {"MZ5 group", 5}, {"RIVAL", 4}, {"Sanflor", 7}, {"Aquanet", 6}, {"FixPrice", 2} });
+	static_assert(delivery_days.At("FixPrice") == 2, "the table is usable in constant expressions");
+	cout << endl << "Delivery time of element 54: " << delivery_days.At(cont_1.At(54).m_manufacturer.Str()) << " days" << endl;
 }
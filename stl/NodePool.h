@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+
+/*
+Пул узлов фиксированного размера. Узлы нарезаются из больших блоков (слэбов), полученных у memory_resource,
+а освобожденные узлы не возвращаются ресурсу, а попадают в список свободных и переиспользуются.
+Освобождение всего пула (Release) стоит O(число слэбов), а не O(число узлов).
+*/
+template<typename _NodeType>
+class NodePool {
+private:
+	struct Slab {
+		Slab* m_next;
+		size_t m_bytes;
+	};
+
+	struct FreeSlot {
+		FreeSlot* m_next;
+	};
+
+	static constexpr size_t kAlignment = alignof(_NodeType) > alignof(Slab) ? alignof(_NodeType) : alignof(Slab);
+	static constexpr size_t kSlotSize = sizeof(_NodeType) > sizeof(FreeSlot) ? sizeof(_NodeType) : sizeof(FreeSlot);
+	static constexpr size_t kHeaderSize = (sizeof(Slab) + kAlignment - 1) / kAlignment * kAlignment;
+	static constexpr size_t kMinSlabNodes = 4;         // маленькие контейнеры не должны держать почти пустой слэб
+	static constexpr size_t kMaxSlabNodes = 4096;
+
+	std::pmr::memory_resource* m_resource;
+	Slab* m_slabs;
+	FreeSlot* m_free;
+	char* m_cur;                 // начало еще не нарезанной части текущего слэба
+	char* m_end;
+	size_t m_next_slab_nodes;
+	size_t m_allocated_bytes;    // сумма размеров слэбов
+
+	char* AllocateSlab(size_t p_nodes) {
+		size_t bytes = kHeaderSize + p_nodes * kSlotSize;
+		Slab* slab = static_cast<Slab*>(m_resource->allocate(bytes, kAlignment));
+		slab->m_next = m_slabs;
+		slab->m_bytes = bytes;
+		m_slabs = slab;
+		m_allocated_bytes += bytes;
+		return reinterpret_cast<char*>(slab) + kHeaderSize;
+	}
+
+	void Reset() {
+		m_slabs = nullptr;
+		m_free = nullptr;
+		m_cur = nullptr;
+		m_end = nullptr;
+		m_next_slab_nodes = kMinSlabNodes;
+		m_allocated_bytes = 0;
+	}
+
+	void Steal(NodePool& p_other) noexcept {
+		m_resource = p_other.m_resource;
+		m_slabs = p_other.m_slabs;
+		m_free = p_other.m_free;
+		m_cur = p_other.m_cur;
+		m_end = p_other.m_end;
+		m_next_slab_nodes = p_other.m_next_slab_nodes;
+		m_allocated_bytes = p_other.m_allocated_bytes;
+		p_other.Reset();
+	}
+
+public:
+	explicit NodePool(std::pmr::memory_resource* p_resource = std::pmr::get_default_resource()) : m_resource(p_resource) {
+		Reset();
+	}
+
+	NodePool(const NodePool&) = delete;
+	NodePool& operator=(const NodePool&) = delete;
+
+	NodePool(NodePool&& p_other) noexcept {
+		Steal(p_other);
+	}
+
+	NodePool& operator=(NodePool&& p_other) noexcept {
+		if (this == &p_other) {
+			return *this;
+		}
+		Release();
+		Steal(p_other);
+		return *this;
+	}
+
+	~NodePool() {
+		Release();
+	}
+
+	// Возвращает неинициализированную память под один узел: из текущего слэба, затем из списка свободных.
+	void* Allocate() {
+		if (m_cur == m_end) {
+			if (m_free) {
+				FreeSlot* slot = m_free;
+				m_free = slot->m_next;
+				return slot;
+			}
+			m_cur = AllocateSlab(m_next_slab_nodes);
+			m_end = m_cur + m_next_slab_nodes * kSlotSize;
+			if (m_next_slab_nodes < kMaxSlabNodes) {
+				m_next_slab_nodes *= 2;
+			}
+		}
+		void* slot = m_cur;
+		m_cur += kSlotSize;
+		return slot;
+	}
+
+	/*
+	Гарантирует, что следующие p_nodes вызовов Allocate возьмут узлы подряд из одного слэба.
+	Остаток текущего слэба при этом не теряется, а уходит в список свободных.
+	*/
+	void Reserve(size_t p_nodes) {
+		if (static_cast<size_t>(m_end - m_cur) >= p_nodes * kSlotSize) {
+			return;
+		}
+		while (m_cur != m_end) {
+			Deallocate(m_cur);
+			m_cur += kSlotSize;
+		}
+		m_cur = AllocateSlab(p_nodes);
+		m_end = m_cur + p_nodes * kSlotSize;
+	}
+
+	// Узел должен быть уже разрушен; память остается в пуле.
+	void Deallocate(void* p_node) {
+		FreeSlot* slot = static_cast<FreeSlot*>(p_node);
+		slot->m_next = m_free;
+		m_free = slot;
+	}
+
+	// Возвращает все слэбы ресурсу. Узлы к этому моменту должны быть разрушены.
+	void Release() {
+		while (m_slabs) {
+			Slab* next = m_slabs->m_next;
+			m_resource->deallocate(m_slabs, m_slabs->m_bytes, kAlignment);
+			m_slabs = next;
+		}
+		Reset();
+	}
+
+	std::pmr::memory_resource* GetResource() const {
+		return m_resource;
+	}
+
+	// Память, полученная у ресурса (вместе с заголовками слэбов и свободными узлами).
+	size_t GetAllocatedBytes() const {
+		return m_allocated_bytes;
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include "Exceptions.h"
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+/*
+Политика параллельного выполнения для перегрузок алгоритмов из Algorithms.h: сколько потоков использовать
+и сколько элементов как минимум должно приходиться на один поток (на маленьких диапазонах запуск потоков дороже работы).
+*/
+class ParallelPolicy {
+private:
+	int m_threads;
+	size_t m_min_chunk;
+public:
+	// 0 потоков - по числу аппаратных потоков.
+	explicit ParallelPolicy(int p_threads = 0, size_t p_min_chunk = 1024) : m_min_chunk(p_min_chunk ? p_min_chunk : 1) {
+		if (p_threads < 0) {
+			throw InvalidValueError("InvalidValueError: invalid thread count.");
+		}
+		unsigned hardware = std::thread::hardware_concurrency();
+		m_threads = p_threads ? p_threads : static_cast<int>(hardware ? hardware : 1);
+	}
+
+	int GetThreadCount() const {
+		return m_threads;
+	}
+
+	size_t GetMinChunk() const {
+		return m_min_chunk;
+	}
+
+	// На сколько частей делить p_count элементов.
+	int PartsFor(size_t p_count) const {
+		size_t parts = (p_count + m_min_chunk - 1) / m_min_chunk;
+		if (parts > static_cast<size_t>(m_threads)) {
+			parts = static_cast<size_t>(m_threads);
+		}
+		return parts ? static_cast<int>(parts) : 1;
+	}
+};
+
+
+// Порядок результата параллельного copyIf: как у исходного диапазона или произвольный (без ожидания всех частей).
+enum class CopyOrder {
+	Preserve,
+	Any
+};
+
+
+// Смещение начала части p_part из p_parts частей диапазона длины p_count.
+inline size_t partOffset(size_t p_count, int p_part, int p_parts) {
+	return p_count / p_parts * p_part + p_count % p_parts * p_part / p_parts;
+}
+
+
+/*
+Вызывает p_func(i) для i из [0, p_parts): часть 0 выполняется в вызывающем потоке, остальные - в отдельных.
+Исключение из любой части пробрасывается после завершения всех потоков.
+*/
+template<typename _Func>
+void parallelRun(int p_parts, _Func p_func) {
+	if (p_parts <= 1) {
+		p_func(0);
+		return;
+	}
+	std::vector<std::exception_ptr> errors(p_parts);
+	std::vector<std::thread> threads;
+	threads.reserve(p_parts - 1);
+	for (int i = 1; i < p_parts; i++) {
+		threads.emplace_back([&p_func, &errors, i] {
+			try {
+				p_func(i);
+			}
+			catch (...) {
+				errors[i] = std::current_exception();
+			}
+		});
+	}
+	try {
+		p_func(0);
+	}
+	catch (...) {
+		errors[0] = std::current_exception();
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
@@ -0,0 +1,438 @@
+#pragma once
+#include "Exceptions.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+/*
+Неизменяемая версия персистентного словаря (снимок PersistentUnorderedMap). Словарь хранится как HAMT - префиксное
+дерево по 5-битным частям хэша с битовыми картами занятых позиций в узлах. Узлы и элементы неизменяемы, пока на них
+есть больше одной ссылки, и разделяются между версиями, поэтому копирование версии стоит O(1).
+Счетчики ссылок атомарны: снимок можно читать и разрушать в любом потоке независимо от словаря, из которого он получен.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>>
+class PersistentUnorderedMapView {
+protected:
+	using PairType = std::pair<const _KeyType, _DataType>;
+
+	static constexpr int kBits = 5;
+	static constexpr int kMaxShift = static_cast<int>(sizeof(size_t) * 8);    // с этого уровня биты хэша кончились: узел коллизий
+
+	struct Leaf {
+		template<typename... _Args>
+		explicit Leaf(size_t p_hash, _Args&&... p_args) : m_refs(1), m_hash(p_hash), m_pair(std::forward<_Args>(p_args)...) {}
+
+		std::atomic<int> m_refs;
+		size_t m_hash;
+		PairType m_pair;
+	};
+
+	/*
+	Элементы и дочерние узлы лежат в порядке своих позиций (номер позиции - очередные kBits бит хэша).
+	В узле коллизий (уровень kMaxShift) карты пусты, а все элементы с одинаковым хэшем лежат в m_leaves подряд.
+	*/
+	struct HamtNode {
+		HamtNode() : m_refs(1), m_leafmap(0), m_nodemap(0) {}
+
+		std::atomic<int> m_refs;
+		uint32_t m_leafmap;
+		uint32_t m_nodemap;
+		std::vector<Leaf*> m_leaves;
+		std::vector<HamtNode*> m_children;
+	};
+
+	HamtNode* m_root;     // nullptr - пустой словарь
+	int m_size;
+	_Hash m_hash_obj;
+	_KeyEqual m_key_equal;
+
+	static int PopCount(uint32_t p_bits) {
+		p_bits = p_bits - ((p_bits >> 1) & 0x55555555u);
+		p_bits = (p_bits & 0x33333333u) + ((p_bits >> 2) & 0x33333333u);
+		return static_cast<int>((((p_bits + (p_bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+	}
+
+	static uint32_t Bit(size_t p_hash, int p_shift) {
+		return 1u << ((p_hash >> p_shift) & 31);
+	}
+
+	// Номер позиции p_bit среди занятых позиций карты p_map.
+	static int Index(uint32_t p_map, uint32_t p_bit) {
+		return PopCount(p_map & (p_bit - 1));
+	}
+
+	template<typename _Type>
+	static _Type* Acquire(_Type* p_ptr) {
+		p_ptr->m_refs.fetch_add(1, std::memory_order_relaxed);
+		return p_ptr;
+	}
+
+	static void Release(Leaf* p_leaf) {
+		if (p_leaf->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete p_leaf;
+		}
+	}
+
+	static void Release(HamtNode* p_node) {
+		if (p_node->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			for (Leaf* leaf : p_node->m_leaves) {
+				Release(leaf);
+			}
+			for (HamtNode* child : p_node->m_children) {
+				Release(child);
+			}
+			delete p_node;
+		}
+	}
+
+	const Leaf* FindLeaf(const _KeyType& p_key, size_t p_hash) const {
+		const HamtNode* node = m_root;
+		int shift = 0;
+		while (node) {
+			if (shift >= kMaxShift) {
+				for (const Leaf* leaf : node->m_leaves) {
+					if (m_key_equal(leaf->m_pair.first, p_key)) {
+						return leaf;
+					}
+				}
+				return nullptr;
+			}
+			uint32_t bit = Bit(p_hash, shift);
+			if (node->m_leafmap & bit) {
+				const Leaf* leaf = node->m_leaves[Index(node->m_leafmap, bit)];
+				return leaf->m_hash == p_hash && m_key_equal(leaf->m_pair.first, p_key) ? leaf : nullptr;
+			}
+			if (!(node->m_nodemap & bit)) {
+				return nullptr;
+			}
+			node = node->m_children[Index(node->m_nodemap, bit)];
+			shift += kBits;
+		}
+		return nullptr;
+	}
+
+	template<typename _Func>
+	static void ForEachIn(const HamtNode* p_node, _Func& p_func) {
+		for (const Leaf* leaf : p_node->m_leaves) {
+			p_func(leaf->m_pair);
+		}
+		for (const HamtNode* child : p_node->m_children) {
+			ForEachIn(child, p_func);
+		}
+	}
+
+	void Steal(PersistentUnorderedMapView& p_other) {
+		m_root = p_other.m_root;
+		m_size = p_other.m_size;
+		m_hash_obj = p_other.m_hash_obj;
+		m_key_equal = p_other.m_key_equal;
+		p_other.m_root = nullptr;
+		p_other.m_size = 0;
+	}
+
+public:
+	PersistentUnorderedMapView() : m_root(nullptr), m_size(0) {}
+
+	PersistentUnorderedMapView(const PersistentUnorderedMapView& p_other) : m_root(p_other.m_root ? Acquire(p_other.m_root) : nullptr),
+		m_size(p_other.m_size), m_hash_obj(p_other.m_hash_obj), m_key_equal(p_other.m_key_equal) {}
+
+	PersistentUnorderedMapView(PersistentUnorderedMapView&& p_other) {
+		Steal(p_other);
+	}
+
+	PersistentUnorderedMapView& operator=(const PersistentUnorderedMapView& p_other) {
+		if (this == &p_other) {
+			return *this;
+		}
+		HamtNode* root = p_other.m_root ? Acquire(p_other.m_root) : nullptr;
+		if (m_root) {
+			Release(m_root);
+		}
+		m_root = root;
+		m_size = p_other.m_size;
+		m_hash_obj = p_other.m_hash_obj;
+		m_key_equal = p_other.m_key_equal;
+		return *this;
+	}
+
+	PersistentUnorderedMapView& operator=(PersistentUnorderedMapView&& p_other) {
+		if (this == &p_other) {
+			return *this;
+		}
+		if (m_root) {
+			Release(m_root);
+		}
+		Steal(p_other);
+		return *this;
+	}
+
+	~PersistentUnorderedMapView() {
+		if (m_root) {
+			Release(m_root);
+		}
+	}
+
+	// Вызывает p_func(const _DataType&) без копирования значения; возвращает false, если ключа нет.
+	template<typename _Func>
+	bool Read(const _KeyType& p_key, _Func p_func) const {
+		const Leaf* leaf = FindLeaf(p_key, m_hash_obj(p_key));
+		if (!leaf) {
+			return false;
+		}
+		p_func(leaf->m_pair.second);
+		return true;
+	}
+
+	std::optional<_DataType> Find(const _KeyType& p_key) const {
+		const Leaf* leaf = FindLeaf(p_key, m_hash_obj(p_key));
+		if (!leaf) {
+			return std::nullopt;
+		}
+		return leaf->m_pair.second;
+	}
+
+	// Ссылка действительна, пока существует эта версия (для PersistentUnorderedMap - до ее следующего изменения).
+	const _DataType& At(const _KeyType& p_key) const {
+		const Leaf* leaf = FindLeaf(p_key, m_hash_obj(p_key));
+		if (!leaf) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return leaf->m_pair.second;
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		return FindLeaf(p_key, m_hash_obj(p_key)) != nullptr;
+	}
+
+	// Вызывает p_func(const PairType&) для каждого элемента; порядок определяется хэшами.
+	template<typename _Func>
+	void ForEach(_Func p_func) const {
+		if (m_root) {
+			ForEachIn(m_root, p_func);
+		}
+	}
+
+	int Size() const {
+		return m_size;
+	}
+
+	bool Empty() const {
+		return m_size == 0;
+	}
+};
+
+
+/*
+Персистентный словарь: копия и снимок (Snapshot) стоят O(1) и разделяют с исходным словарем всю структуру.
+Изменение меняет на месте узлы и элементы, на которые больше никто не ссылается, а разделяемые копирует -
+только на пути от корня к изменяемому элементу (не больше 13 узлов). Поэтому снимок занимает память
+пропорционально числу изменений, сделанных после него, а не размеру словаря.
+Сам словарь, как и UnorderedMap, не потокобезопасен: снимки берутся в потоке писателя (или под его блокировкой)
+и дальше передаются читателям.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>>
+class PersistentUnorderedMap : public PersistentUnorderedMapView<_KeyType, _DataType, _Hash, _KeyEqual> {
+private:
+	using ViewType = PersistentUnorderedMapView<_KeyType, _DataType, _Hash, _KeyEqual>;
+	using typename ViewType::PairType;
+	using typename ViewType::Leaf;
+	using typename ViewType::HamtNode;
+	using ViewType::kBits;
+	using ViewType::kMaxShift;
+	using ViewType::m_root;
+	using ViewType::m_size;
+	using ViewType::m_hash_obj;
+	using ViewType::m_key_equal;
+	using ViewType::Bit;
+	using ViewType::Index;
+	using ViewType::Acquire;
+	using ViewType::Release;
+
+	// Узел, который можно менять на месте: сам p_node, если других ссылок на него нет, иначе его копия.
+	static HamtNode* Editable(HamtNode* p_node) {
+		if (p_node->m_refs.load(std::memory_order_acquire) == 1) {
+			return p_node;
+		}
+		HamtNode* copy = new HamtNode();
+		copy->m_leafmap = p_node->m_leafmap;
+		copy->m_nodemap = p_node->m_nodemap;
+		copy->m_leaves = p_node->m_leaves;
+		copy->m_children = p_node->m_children;
+		for (Leaf* leaf : copy->m_leaves) {
+			Acquire(leaf);
+		}
+		for (HamtNode* child : copy->m_children) {
+			Acquire(child);
+		}
+		Release(p_node);
+		return copy;
+	}
+
+	// Разделяемый элемент не меняется, а заменяется новым.
+	template<typename _Value>
+	static void Assign(Leaf*& p_leaf, _Value&& p_value) {
+		if (p_leaf->m_refs.load(std::memory_order_acquire) == 1) {
+			p_leaf->m_pair.second = std::forward<_Value>(p_value);
+			return;
+		}
+		Leaf* leaf = new Leaf(p_leaf->m_hash, p_leaf->m_pair.first, std::forward<_Value>(p_value));
+		Release(p_leaf);
+		p_leaf = leaf;
+	}
+
+	// Узел из двух элементов, совпавших в позиции на предыдущем уровне; элементы переходят в него без копирования.
+	static HamtNode* MakeNode(Leaf* p_first, Leaf* p_second, int p_shift) {
+		HamtNode* node = new HamtNode();
+		if (p_shift >= kMaxShift) {
+			node->m_leaves = { p_first, p_second };
+			return node;
+		}
+		uint32_t first_bit = Bit(p_first->m_hash, p_shift);
+		uint32_t second_bit = Bit(p_second->m_hash, p_shift);
+		if (first_bit == second_bit) {
+			node->m_nodemap = first_bit;
+			node->m_children.push_back(MakeNode(p_first, p_second, p_shift + kBits));
+		}
+		else {
+			node->m_leafmap = first_bit | second_bit;
+			node->m_leaves = first_bit < second_bit ? std::vector<Leaf*>{ p_first, p_second } : std::vector<Leaf*>{ p_second, p_first };
+		}
+		return node;
+	}
+
+	// p_node уже можно менять на месте; возвращает true, если ключ был новым.
+	template<typename _Value>
+	bool InsertInto(HamtNode* p_node, int p_shift, size_t p_hash, const _KeyType& p_key, _Value&& p_value) {
+		if (p_shift >= kMaxShift) {
+			for (Leaf*& leaf : p_node->m_leaves) {
+				if (m_key_equal(leaf->m_pair.first, p_key)) {
+					Assign(leaf, std::forward<_Value>(p_value));
+					return false;
+				}
+			}
+			p_node->m_leaves.push_back(new Leaf(p_hash, p_key, std::forward<_Value>(p_value)));
+			return true;
+		}
+		uint32_t bit = Bit(p_hash, p_shift);
+		if (p_node->m_leafmap & bit) {
+			int index = Index(p_node->m_leafmap, bit);
+			Leaf*& leaf = p_node->m_leaves[index];
+			if (leaf->m_hash == p_hash && m_key_equal(leaf->m_pair.first, p_key)) {
+				Assign(leaf, std::forward<_Value>(p_value));
+				return false;
+			}
+			HamtNode* child = MakeNode(leaf, new Leaf(p_hash, p_key, std::forward<_Value>(p_value)), p_shift + kBits);
+			p_node->m_leaves.erase(p_node->m_leaves.begin() + index);
+			p_node->m_leafmap ^= bit;
+			p_node->m_children.insert(p_node->m_children.begin() + Index(p_node->m_nodemap, bit), child);
+			p_node->m_nodemap |= bit;
+			return true;
+		}
+		if (p_node->m_nodemap & bit) {
+			HamtNode*& child = p_node->m_children[Index(p_node->m_nodemap, bit)];
+			child = Editable(child);
+			return InsertInto(child, p_shift + kBits, p_hash, p_key, std::forward<_Value>(p_value));
+		}
+		p_node->m_leaves.insert(p_node->m_leaves.begin() + Index(p_node->m_leafmap, bit), new Leaf(p_hash, p_key, std::forward<_Value>(p_value)));
+		p_node->m_leafmap |= bit;
+		return true;
+	}
+
+	/*
+	p_node уже можно менять на месте, ключ в нем точно есть. Дочерний узел, в котором остался один элемент,
+	заменяется этим элементом, так что форма дерева не зависит от порядка вставок и удалений.
+	*/
+	void EraseFrom(HamtNode* p_node, int p_shift, size_t p_hash, const _KeyType& p_key) {
+		if (p_shift >= kMaxShift) {
+			for (size_t i = 0; i < p_node->m_leaves.size(); i++) {
+				if (m_key_equal(p_node->m_leaves[i]->m_pair.first, p_key)) {
+					Release(p_node->m_leaves[i]);
+					p_node->m_leaves.erase(p_node->m_leaves.begin() + i);
+					return;
+				}
+			}
+			return;
+		}
+		uint32_t bit = Bit(p_hash, p_shift);
+		if (p_node->m_leafmap & bit) {
+			int index = Index(p_node->m_leafmap, bit);
+			Release(p_node->m_leaves[index]);
+			p_node->m_leaves.erase(p_node->m_leaves.begin() + index);
+			p_node->m_leafmap ^= bit;
+			return;
+		}
+		int index = Index(p_node->m_nodemap, bit);
+		HamtNode* child = Editable(p_node->m_children[index]);
+		p_node->m_children[index] = child;
+		EraseFrom(child, p_shift + kBits, p_hash, p_key);
+		if (child->m_children.empty() && child->m_leaves.size() == 1) {
+			Leaf* leaf = child->m_leaves[0];
+			child->m_leaves.clear();
+			Release(child);
+			p_node->m_children.erase(p_node->m_children.begin() + index);
+			p_node->m_nodemap ^= bit;
+			p_node->m_leaves.insert(p_node->m_leaves.begin() + Index(p_node->m_leafmap, bit), leaf);
+			p_node->m_leafmap |= bit;
+		}
+	}
+
+	template<typename _Value>
+	bool InsertImpl(const _KeyType& p_key, _Value&& p_value) {
+		size_t hash = m_hash_obj(p_key);
+		m_root = m_root ? Editable(m_root) : new HamtNode();
+		bool inserted = InsertInto(m_root, 0, hash, p_key, std::forward<_Value>(p_value));
+		if (inserted) {
+			m_size++;
+		}
+		return inserted;
+	}
+
+public:
+	PersistentUnorderedMap() {}
+
+	PersistentUnorderedMap(const std::initializer_list<PairType>& p_list) {
+		for (auto& elem : p_list) {
+			Insert(elem);
+		}
+	}
+
+	// Вставляет пару или заменяет значение существующего ключа; возвращает true, если ключ был новым.
+	bool Insert(const PairType& p_pair) {
+		return InsertImpl(p_pair.first, p_pair.second);
+	}
+
+	bool Insert(PairType&& p_pair) {
+		return InsertImpl(p_pair.first, std::move(p_pair.second));
+	}
+
+	// Возвращает true, если ключ был и удален. Отсутствующий ключ не вызывает копирования разделяемых узлов.
+	bool Erase(const _KeyType& p_key) {
+		size_t hash = m_hash_obj(p_key);
+		if (!this->FindLeaf(p_key, hash)) {
+			return false;
+		}
+		m_root = Editable(m_root);
+		EraseFrom(m_root, 0, hash, p_key);
+		m_size--;
+		return true;
+	}
+
+	void Clear() {
+		if (m_root) {
+			Release(m_root);
+			m_root = nullptr;
+		}
+		m_size = 0;
+	}
+
+	// Неизменяемый снимок текущего состояния за O(1); последующие изменения словаря на нем не отражаются.
+	ViewType Snapshot() const {
+		return ViewType(*this);
+	}
+};
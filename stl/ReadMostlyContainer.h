@@ -0,0 +1,441 @@
+#pragma once
+#include "Exceptions.h"
+#include "Hash.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+/*
+Эпохи для отложенного освобождения памяти (epoch-based reclamation), общие для всех ReadMostlyUnorderedMap.
+Читатель на время обращения записывает текущую глобальную эпоху в свой слот (обычная запись и барьер,
+без атомарных операций чтения-модификации-записи), а в конце обнуляет слот. Писатель, исключив узел или массив
+корзин из структуры, помечает его текущей эпохой и освобождает, только когда ни один активный читатель
+не объявил эпоху, не превышающую эту метку.
+Слотов kMaxThreads; потоки сверх этого числа читают через общий слот переполнения под мьютексом.
+*/
+class EpochDomain {
+public:
+	static constexpr int kMaxThreads = 512;
+
+	// RAII-охрана читателя; допускает вложенность (в том числе при чтении нескольких контейнеров).
+	class Guard {
+	public:
+		Guard() {
+			ThreadRecord& record = Record();
+			if (record.m_depth++ == 0) {
+				if (!record.m_slot) {
+					record.m_slot = AcquireSlot();
+				}
+				if (record.m_slot) {
+					record.m_slot->m_epoch.store(GlobalEpoch().load(std::memory_order_relaxed), std::memory_order_relaxed);
+				}
+				else {
+					EnterOverflow();
+				}
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+
+		~Guard() {
+			ThreadRecord& record = Record();
+			if (--record.m_depth == 0) {
+				if (record.m_slot) {
+					record.m_slot->m_epoch.store(0, std::memory_order_release);
+				}
+				else {
+					LeaveOverflow();
+				}
+			}
+		}
+
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+	};
+
+	// Вызывается писателем после исключения объекта из структуры; возвращает метку для него.
+	static uint64_t Retire() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return GlobalEpoch().fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	// Объект с меткой p_epoch можно освободить, если все активные читатели вошли позже.
+	static uint64_t MinActiveEpoch() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		uint64_t min_epoch = UINT64_MAX;
+		Slot* slots = Slots();
+		for (int i = 0; i <= kMaxThreads; i++) {
+			uint64_t epoch = slots[i].m_epoch.load(std::memory_order_acquire);
+			if (epoch && epoch < min_epoch) {
+				min_epoch = epoch;
+			}
+		}
+		return min_epoch;
+	}
+
+	/*
+	Освобождает слот вызывающего потока для других потоков (вне Guard). Полезно для короткоживущих потоков
+	и пулов, где потоков больше kMaxThreads; при следующем чтении поток займет слот заново.
+	*/
+	static void ReleaseThreadSlot() {
+		ThreadRecord& record = Record();
+		if (record.m_depth == 0) {
+			record.Release();
+		}
+	}
+
+private:
+	struct alignas(64) Slot {
+		std::atomic<uint64_t> m_epoch{ 0 };   // 0 - поток сейчас не читает
+		std::atomic<bool> m_used{ false };
+	};
+
+	struct ThreadRecord {
+		Slot* m_slot = nullptr;
+		int m_depth = 0;
+
+		void Release() {
+			if (m_slot) {
+				m_slot->m_epoch.store(0, std::memory_order_release);
+				m_slot->m_used.store(false, std::memory_order_release);
+				m_slot = nullptr;
+			}
+		}
+
+		~ThreadRecord() {
+			Release();
+		}
+	};
+
+	// kMaxThreads слотов потоков и последний - слот переполнения.
+	static Slot* Slots() {
+		static Slot slots[kMaxThreads + 1];
+		return slots;
+	}
+
+	struct Overflow {
+		std::mutex m_mutex;
+		int m_readers = 0;
+	};
+
+	static Overflow& OverflowState() {
+		static Overflow overflow;
+		return overflow;
+	}
+
+	/*
+	Слот переполнения хранит эпоху первого из читающих через него потоков и обнуляется, когда уходит последний.
+	Более ранняя эпоха лишь откладывает освобождение, поэтому это безопасно.
+	*/
+	static void EnterOverflow() {
+		Overflow& overflow = OverflowState();
+		std::lock_guard<std::mutex> lock(overflow.m_mutex);
+		if (overflow.m_readers++ == 0) {
+			Slots()[kMaxThreads].m_epoch.store(GlobalEpoch().load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	static void LeaveOverflow() {
+		Overflow& overflow = OverflowState();
+		std::lock_guard<std::mutex> lock(overflow.m_mutex);
+		if (--overflow.m_readers == 0) {
+			Slots()[kMaxThreads].m_epoch.store(0, std::memory_order_release);
+		}
+	}
+
+	static std::atomic<uint64_t>& GlobalEpoch() {
+		static std::atomic<uint64_t> epoch{ 1 };
+		return epoch;
+	}
+
+	static ThreadRecord& Record() {
+		thread_local ThreadRecord record;
+		return record;
+	}
+
+	// Слот занимается до завершения потока или ReleaseThreadSlot; если все заняты - nullptr (читаем через слот переполнения).
+	static Slot* AcquireSlot() {
+		Slot* slots = Slots();
+		for (int i = 0; i < kMaxThreads; i++) {
+			bool expected = false;
+			if (!slots[i].m_used.load(std::memory_order_relaxed) &&
+				slots[i].m_used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+				return &slots[i];
+			}
+		}
+		return nullptr;
+	}
+};
+
+
+/*
+Словарь для сценария "много чтений, редкие изменения". Find/At/Contains/Read/ForEach не берут блокировок
+и не выполняют атомарных операций чтения-модификации-записи: они идут по односвязным цепочкам,
+опубликованным писателем через release-записи. Элементы неизменяемы: изменение значения заменяет узел целиком.
+Писатели сериализуются мьютексом; исключенные узлы и старые массивы корзин освобождаются через EpochDomain.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>, typename _KeyEqual = std::equal_to<_KeyType>>
+class ReadMostlyUnorderedMap {
+private:
+	using PairType = std::pair<const _KeyType, _DataType>;
+
+	struct Node {
+		template<typename... _Args>
+		explicit Node(size_t p_hash, _Args&&... p_args) : m_pair(std::forward<_Args>(p_args)...), m_hash(p_hash), m_next(nullptr) {}
+
+		const PairType m_pair;
+		size_t m_hash;
+		std::atomic<Node*> m_next;
+	};
+
+	struct Table {
+		explicit Table(int p_buckets) : m_buckets(p_buckets), m_heads(new std::atomic<Node*>[p_buckets]) {
+			m_policy.Reset(p_buckets);
+			for (int i = 0; i < p_buckets; i++) {
+				m_heads[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		int m_buckets;
+		PowerOfTwoBucketPolicy m_policy;
+		std::unique_ptr<std::atomic<Node*>[]> m_heads;
+	};
+
+	// Отложенно освобождаемый объект: отдельный узел или массив корзин вместе со всеми его узлами.
+	struct Retired {
+		uint64_t m_epoch;
+		Node* m_node;
+		Table* m_table;
+	};
+
+	std::atomic<Table*> m_table;
+	std::atomic<int> m_size;
+	double m_max_load_factor;
+	_Hash m_hash_obj;
+	_KeyEqual m_key_equal;
+	std::mutex m_write_mutex;
+	std::vector<Retired> m_retired;
+
+	static void DeleteTable(Table* p_table) {
+		for (int i = 0; i < p_table->m_buckets; i++) {
+			Node* cur_ptr = p_table->m_heads[i].load(std::memory_order_relaxed);
+			while (cur_ptr) {
+				Node* next_ptr = cur_ptr->m_next.load(std::memory_order_relaxed);
+				delete cur_ptr;
+				cur_ptr = next_ptr;
+			}
+		}
+		delete p_table;
+	}
+
+	static void Free(const Retired& p_retired) {
+		if (p_retired.m_table) {
+			DeleteTable(p_retired.m_table);
+		}
+		else {
+			delete p_retired.m_node;
+		}
+	}
+
+	// Вызывается писателем под m_write_mutex.
+	void Reclaim() {
+		if (m_retired.empty()) {
+			return;
+		}
+		uint64_t min_epoch = EpochDomain::MinActiveEpoch();
+		size_t kept = 0;
+		for (size_t i = 0; i < m_retired.size(); i++) {
+			if (m_retired[i].m_epoch < min_epoch) {
+				Free(m_retired[i]);
+			}
+			else {
+				m_retired[kept++] = m_retired[i];
+			}
+		}
+		m_retired.resize(kept);
+	}
+
+	const Node* FindNode(const Table* p_table, const _KeyType& p_key, size_t p_hash) const {
+		const Node* cur_ptr = p_table->m_heads[p_table->m_policy.Index(p_hash)].load(std::memory_order_acquire);
+		while (cur_ptr) {
+			if (cur_ptr->m_hash == p_hash && m_key_equal(cur_ptr->m_pair.first, p_key)) {
+				return cur_ptr;
+			}
+			cur_ptr = cur_ptr->m_next.load(std::memory_order_acquire);
+		}
+		return nullptr;
+	}
+
+	// Новый массив строится целиком в стороне из копий узлов и публикуется одной release-записью.
+	void Grow(Table* p_table) {
+		Table* table = new Table(PowerOfTwoBucketPolicy::RoundBuckets(p_table->m_buckets * 2));
+		for (int i = 0; i < p_table->m_buckets; i++) {
+			const Node* cur_ptr = p_table->m_heads[i].load(std::memory_order_relaxed);
+			while (cur_ptr) {
+				Node* node = new Node(cur_ptr->m_hash, cur_ptr->m_pair);
+				std::atomic<Node*>& head = table->m_heads[table->m_policy.Index(node->m_hash)];
+				node->m_next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				head.store(node, std::memory_order_relaxed);
+				cur_ptr = cur_ptr->m_next.load(std::memory_order_relaxed);
+			}
+		}
+		m_table.store(table, std::memory_order_release);
+		m_retired.push_back({ EpochDomain::Retire(), nullptr, p_table });
+	}
+
+	template<typename _Value>
+	bool InsertImpl(const _KeyType& p_key, _Value&& p_value) {
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		Table* table = m_table.load(std::memory_order_relaxed);
+		size_t hash = m_hash_obj(p_key);
+		std::atomic<Node*>* link = &table->m_heads[table->m_policy.Index(hash)];
+		Node* cur_ptr = link->load(std::memory_order_relaxed);
+		while (cur_ptr && !(cur_ptr->m_hash == hash && m_key_equal(cur_ptr->m_pair.first, p_key))) {
+			link = &cur_ptr->m_next;
+			cur_ptr = link->load(std::memory_order_relaxed);
+		}
+		Node* node = new Node(hash, p_key, std::forward<_Value>(p_value));
+		if (cur_ptr) {
+			node->m_next.store(cur_ptr->m_next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			link->store(node, std::memory_order_release);
+			m_retired.push_back({ EpochDomain::Retire(), cur_ptr, nullptr });
+			Reclaim();
+			return false;
+		}
+		std::atomic<Node*>& head = table->m_heads[table->m_policy.Index(hash)];
+		node->m_next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		head.store(node, std::memory_order_release);
+		int size = m_size.load(std::memory_order_relaxed) + 1;
+		m_size.store(size, std::memory_order_relaxed);
+		if (size / static_cast<double>(table->m_buckets) >= m_max_load_factor) {
+			Grow(table);
+		}
+		Reclaim();
+		return true;
+	}
+
+public:
+	ReadMostlyUnorderedMap() : m_table(new Table(PowerOfTwoBucketPolicy::RoundBuckets(8))), m_size(0), m_max_load_factor(1.) {}
+
+	ReadMostlyUnorderedMap(const std::initializer_list<PairType>& p_list) : ReadMostlyUnorderedMap() {
+		for (auto& elem : p_list) {
+			Insert(elem);
+		}
+	}
+
+	ReadMostlyUnorderedMap(const ReadMostlyUnorderedMap&) = delete;
+	ReadMostlyUnorderedMap& operator=(const ReadMostlyUnorderedMap&) = delete;
+
+	// К моменту разрушения читателей быть не должно, поэтому все освобождается сразу.
+	~ReadMostlyUnorderedMap() {
+		for (auto& retired : m_retired) {
+			Free(retired);
+		}
+		DeleteTable(m_table.load(std::memory_order_relaxed));
+	}
+
+	// Вставляет пару или заменяет значение существующего ключа; возвращает true, если ключ был новым.
+	bool Insert(const PairType& p_pair) {
+		return InsertImpl(p_pair.first, p_pair.second);
+	}
+
+	bool Insert(PairType&& p_pair) {
+		return InsertImpl(p_pair.first, std::move(p_pair.second));
+	}
+
+	// Возвращает true, если ключ был и удален.
+	bool Erase(const _KeyType& p_key) {
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		Table* table = m_table.load(std::memory_order_relaxed);
+		size_t hash = m_hash_obj(p_key);
+		std::atomic<Node*>* link = &table->m_heads[table->m_policy.Index(hash)];
+		Node* cur_ptr = link->load(std::memory_order_relaxed);
+		while (cur_ptr && !(cur_ptr->m_hash == hash && m_key_equal(cur_ptr->m_pair.first, p_key))) {
+			link = &cur_ptr->m_next;
+			cur_ptr = link->load(std::memory_order_relaxed);
+		}
+		if (!cur_ptr) {
+			return false;
+		}
+		link->store(cur_ptr->m_next.load(std::memory_order_relaxed), std::memory_order_release);
+		m_size.store(m_size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		m_retired.push_back({ EpochDomain::Retire(), cur_ptr, nullptr });
+		Reclaim();
+		return true;
+	}
+
+	void Clear() {
+		std::lock_guard<std::mutex> lock(m_write_mutex);
+		Table* table = m_table.load(std::memory_order_relaxed);
+		m_table.store(new Table(table->m_buckets), std::memory_order_release);
+		m_size.store(0, std::memory_order_relaxed);
+		m_retired.push_back({ EpochDomain::Retire(), nullptr, table });
+		Reclaim();
+	}
+
+	// Вызывает p_func(const _DataType&) без копирования значения; возвращает false, если ключа нет.
+	template<typename _Func>
+	bool Read(const _KeyType& p_key, _Func p_func) const {
+		EpochDomain::Guard guard;
+		const Node* node = FindNode(m_table.load(std::memory_order_acquire), p_key, m_hash_obj(p_key));
+		if (!node) {
+			return false;
+		}
+		p_func(node->m_pair.second);
+		return true;
+	}
+
+	std::optional<_DataType> Find(const _KeyType& p_key) const {
+		EpochDomain::Guard guard;
+		const Node* node = FindNode(m_table.load(std::memory_order_acquire), p_key, m_hash_obj(p_key));
+		if (!node) {
+			return std::nullopt;
+		}
+		return node->m_pair.second;
+	}
+
+	_DataType At(const _KeyType& p_key) const {
+		EpochDomain::Guard guard;
+		const Node* node = FindNode(m_table.load(std::memory_order_acquire), p_key, m_hash_obj(p_key));
+		if (!node) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return node->m_pair.second;
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		EpochDomain::Guard guard;
+		return FindNode(m_table.load(std::memory_order_acquire), p_key, m_hash_obj(p_key)) != nullptr;
+	}
+
+	// Обход одного опубликованного массива корзин; параллельные изменения могут быть видны частично.
+	template<typename _Func>
+	void ForEach(_Func p_func) const {
+		EpochDomain::Guard guard;
+		const Table* table = m_table.load(std::memory_order_acquire);
+		for (int i = 0; i < table->m_buckets; i++) {
+			const Node* cur_ptr = table->m_heads[i].load(std::memory_order_acquire);
+			while (cur_ptr) {
+				p_func(cur_ptr->m_pair);
+				cur_ptr = cur_ptr->m_next.load(std::memory_order_acquire);
+			}
+		}
+	}
+
+	int Size() const {
+		return m_size.load(std::memory_order_relaxed);
+	}
+
+	bool Empty() const {
+		return Size() == 0;
+	}
+
+	int GetBucketCount() const {
+		return m_table.load(std::memory_order_acquire)->m_buckets;
+	}
+};
@@ -0,0 +1,155 @@
+#include "Serialization.h"
+#include <cmath>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& p_path) : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+	m_file = CreateFileA(p_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		throw FileError("FileError: cannot open file '" + p_path + "'.");
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+		Close();
+		throw FileError("FileError: cannot map file '" + p_path + "'.");
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping) {
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!m_data) {
+		Close();
+		throw FileError("FileError: cannot map file '" + p_path + "'.");
+	}
+}
+
+void MappedFile::Close() {
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+MappedFile::MappedFile(MappedFile&& p_other) : m_data(p_other.m_data), m_size(p_other.m_size), m_file(p_other.m_file), m_mapping(p_other.m_mapping) {
+	p_other.m_data = nullptr;
+	p_other.m_size = 0;
+	p_other.m_file = INVALID_HANDLE_VALUE;
+	p_other.m_mapping = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& p_other) {
+	if (this == &p_other) {
+		return *this;
+	}
+	Close();
+	m_data = p_other.m_data;
+	m_size = p_other.m_size;
+	m_file = p_other.m_file;
+	m_mapping = p_other.m_mapping;
+	p_other.m_data = nullptr;
+	p_other.m_size = 0;
+	p_other.m_file = INVALID_HANDLE_VALUE;
+	p_other.m_mapping = nullptr;
+	return *this;
+}
+
+#else
+
+// Дескриптор после mmap не нужен: отображение остается действительным до munmap.
+MappedFile::MappedFile(const std::string& p_path) : m_data(nullptr), m_size(0) {
+	int fd = open(p_path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw FileError("FileError: cannot open file '" + p_path + "'.");
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		throw FileError("FileError: cannot map file '" + p_path + "'.");
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		throw FileError("FileError: cannot map file '" + p_path + "'.");
+	}
+	m_data = static_cast<const char*>(data);
+	m_size = static_cast<size_t>(info.st_size);
+}
+
+void MappedFile::Close() {
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& p_other) : m_data(p_other.m_data), m_size(p_other.m_size) {
+	p_other.m_data = nullptr;
+	p_other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& p_other) {
+	if (this == &p_other) {
+		return *this;
+	}
+	Close();
+	m_data = p_other.m_data;
+	m_size = p_other.m_size;
+	p_other.m_data = nullptr;
+	p_other.m_size = 0;
+	return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+
+const MapFileHeader& checkMapFile(const char* p_data, size_t p_size) {
+	if (p_size < sizeof(MapFileHeader)) {
+		throw InvalidValueError("InvalidValueError: file is not a serialized UnorderedMap.");
+	}
+	const MapFileHeader& header = *reinterpret_cast<const MapFileHeader*>(p_data);
+	if (std::memcmp(header.m_magic, MapFileHeader::kMagic, sizeof(header.m_magic)) != 0 || header.m_version != MapFileHeader::kVersion) {
+		throw InvalidValueError("InvalidValueError: file is not a serialized UnorderedMap.");
+	}
+	if (header.m_byte_order != MapFileHeader::kByteOrder || header.m_hash_size != sizeof(size_t)) {
+		throw InvalidValueError("InvalidValueError: file was written on an incompatible platform.");
+	}
+	bool valid = header.m_file_size == p_size && header.m_buckets > 0 && header.m_buckets <= (1u << 30) &&
+		header.m_buckets_offset == sizeof(MapFileHeader) &&
+		header.m_entries_offset == header.m_buckets_offset + (header.m_buckets + 1) * sizeof(uint64_t) &&
+		header.m_entries_offset <= header.m_file_size &&
+		header.m_size <= (header.m_file_size - header.m_entries_offset) / sizeof(MapFileEntry) &&
+		header.m_payload_offset == header.m_entries_offset + header.m_size * sizeof(MapFileEntry) &&
+		header.m_payload_offset <= header.m_file_size &&
+		header.m_map_buckets > 0 && header.m_map_buckets <= (1u << 30) &&
+		std::isfinite(header.m_max_load_factor) && header.m_max_load_factor > 0;
+	if (!valid) {
+		throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+	}
+	return header;
+}
@@ -0,0 +1,421 @@
+#pragma once
+#include "Container.h"
+#include "Exceptions.h"
+#include "Hash.h"
+#include "Intern.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/*
+Сериализатор типа: Write дописывает байты значения в p_out, Read восстанавливает значение целиком,
+View дает представление значения прямо поверх байтов файла, без разбора и выделения памяти
+(для MappedUnorderedMap). Для своих типов (например, Goods) объявляется специализация Serializer.
+*/
+template<typename _Type, typename = void>
+struct Serializer;
+
+template<typename _Type>
+struct Serializer<_Type, typename std::enable_if<std::is_trivially_copyable<_Type>::value>::type> {
+	using ViewType = _Type;
+
+	static void Write(std::string& p_out, const _Type& p_value) {
+		p_out.append(reinterpret_cast<const char*>(&p_value), sizeof(_Type));
+	}
+
+	static _Type Read(const char* p_data, size_t p_size) {
+		return View(p_data, p_size);
+	}
+
+	static ViewType View(const char* p_data, size_t p_size) {
+		if (p_size != sizeof(_Type)) {
+			throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+		}
+		_Type value;
+		std::memcpy(&value, p_data, sizeof(_Type));
+		return value;
+	}
+};
+
+template<>
+struct Serializer<std::string> {
+	using ViewType = std::string_view;
+
+	static void Write(std::string& p_out, const std::string& p_value) {
+		p_out.append(p_value);
+	}
+
+	static std::string Read(const char* p_data, size_t p_size) {
+		return std::string(p_data, p_size);
+	}
+
+	static ViewType View(const char* p_data, size_t p_size) {
+		return ViewType(p_data, p_size);
+	}
+};
+
+
+// Номер строки в пуле действителен только в своем процессе, поэтому в файл пишется сама строка.
+template<>
+struct Serializer<InternedString> {
+	using ViewType = std::string_view;
+
+	static void Write(std::string& p_out, const InternedString& p_value) {
+		p_out.append(p_value.Str());
+	}
+
+	static InternedString Read(const char* p_data, size_t p_size) {
+		return InternedString(std::string_view(p_data, p_size));
+	}
+
+	static ViewType View(const char* p_data, size_t p_size) {
+		return ViewType(p_data, p_size);
+	}
+};
+
+
+// Запись составного значения как последовательности полей, каждое с 32-битным префиксом длины.
+class FieldWriter {
+private:
+	std::string& m_out;
+public:
+	explicit FieldWriter(std::string& p_out) : m_out(p_out) {}
+
+	template<typename _Type>
+	FieldWriter& Add(const _Type& p_value) {
+		size_t size_pos = m_out.size();
+		m_out.append(sizeof(uint32_t), '\0');
+		Serializer<_Type>::Write(m_out, p_value);
+		uint32_t size = static_cast<uint32_t>(m_out.size() - size_pos - sizeof(uint32_t));
+		std::memcpy(&m_out[size_pos], &size, sizeof(size));
+		return *this;
+	}
+};
+
+// Чтение полей, записанных FieldWriter, в том же порядке.
+class FieldReader {
+private:
+	const char* m_cur;
+	const char* m_end;
+
+	std::pair<const char*, size_t> Next() {
+		uint32_t size;
+		if (static_cast<size_t>(m_end - m_cur) < sizeof(size)) {
+			throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+		}
+		std::memcpy(&size, m_cur, sizeof(size));
+		m_cur += sizeof(size);
+		if (static_cast<size_t>(m_end - m_cur) < size) {
+			throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+		}
+		const char* data = m_cur;
+		m_cur += size;
+		return { data, size };
+	}
+public:
+	FieldReader(const char* p_data, size_t p_size) : m_cur(p_data), m_end(p_data + p_size) {}
+
+	template<typename _Type>
+	_Type Read() {
+		std::pair<const char*, size_t> field = Next();
+		return Serializer<_Type>::Read(field.first, field.second);
+	}
+
+	template<typename _Type>
+	typename Serializer<_Type>::ViewType View() {
+		std::pair<const char*, size_t> field = Next();
+		return Serializer<_Type>::View(field.first, field.second);
+	}
+};
+
+
+/*
+Формат файла (порядок байт и размер size_t - как у записавшей машины, это проверяется при открытии):
+заголовок, массив из m_buckets + 1 начал корзин в массиве записей, записи, упорядоченные по корзинам,
+и область данных с сериализованными ключами и значениями (каждый с границы 8 байт).
+Корзины файла выбираются PowerOfTwoBucketPolicy по сохраненному полному хэшу ключа.
+*/
+struct MapFileHeader {
+	static constexpr char kMagic[8] = { 'S', 'T', 'L', 'U', 'M', 'A', 'P', '\0' };
+	static constexpr uint32_t kVersion = 1;
+	static constexpr uint32_t kByteOrder = 0x01020304;
+
+	char m_magic[8];
+	uint32_t m_version;
+	uint32_t m_byte_order;
+	uint32_t m_hash_size;
+	uint32_t m_reserved;
+	uint64_t m_size;
+	uint64_t m_buckets;
+	uint64_t m_map_buckets;         // число корзин сохраненного контейнера, восстанавливается loadUnorderedMap
+	double m_max_load_factor;
+	uint64_t m_buckets_offset;
+	uint64_t m_entries_offset;
+	uint64_t m_payload_offset;
+	uint64_t m_file_size;
+};
+
+struct MapFileEntry {
+	uint64_t m_hash;
+	uint64_t m_key_offset;          // смещения от начала области данных
+	uint64_t m_value_offset;
+	uint32_t m_key_size;
+	uint32_t m_value_size;
+};
+
+
+// Файл, отображенный в память только для чтения; страницы разделяются всеми процессами, открывшими тот же файл.
+class MappedFile {
+private:
+	const char* m_data;
+	size_t m_size;
+#if defined(_WIN32)
+	void* m_file;
+	void* m_mapping;
+#endif
+
+	void Close();
+public:
+	explicit MappedFile(const std::string& p_path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& p_other);
+	MappedFile& operator=(MappedFile&& p_other);
+	~MappedFile();
+
+	const char* GetData() const {
+		return m_data;
+	}
+
+	size_t GetSize() const {
+		return m_size;
+	}
+};
+
+// Проверяет заголовок и границы разделов файла; возвращает заголовок.
+const MapFileHeader& checkMapFile(const char* p_data, size_t p_size);
+
+// Лежит ли участок [p_offset, p_offset + p_size) внутри области данных; сумма не вычисляется, чтобы она не переполнилась.
+inline bool inPayload(uint64_t p_offset, uint32_t p_size, size_t p_payload_size) {
+	return p_size <= p_payload_size && p_offset <= p_payload_size - p_size;
+}
+
+
+/*
+Сохраняет контейнер в файл p_path. Хэши берутся из узлов, хэш-функция не вызывается.
+Файл читается loadUnorderedMap и MappedUnorderedMap программой с теми же типами и той же хэш-функцией.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash, typename _KeyEqual, typename _BucketPolicy>
+void saveUnorderedMap(const UnorderedMap<_KeyType, _DataType, _Hash, _KeyEqual, _BucketPolicy>& p_map, const std::string& p_path) {
+	MapFileHeader header = {};
+	std::memcpy(header.m_magic, MapFileHeader::kMagic, sizeof(header.m_magic));
+	header.m_version = MapFileHeader::kVersion;
+	header.m_byte_order = MapFileHeader::kByteOrder;
+	header.m_hash_size = sizeof(size_t);
+	header.m_size = static_cast<uint64_t>(p_map.Size());
+	header.m_buckets = static_cast<uint64_t>(PowerOfTwoBucketPolicy::RoundBuckets(p_map.GetBucketCount()));
+	header.m_map_buckets = static_cast<uint64_t>(p_map.GetBucketCount());
+	header.m_max_load_factor = p_map.MaxLoadFactor();
+
+	PowerOfTwoBucketPolicy policy;
+	policy.Reset(static_cast<int>(header.m_buckets));
+	std::vector<uint64_t> bucket_starts(header.m_buckets + 1, 0);
+	std::vector<MapFileEntry> unordered;
+	std::vector<int> buckets;
+	unordered.reserve(p_map.Size());
+	buckets.reserve(p_map.Size());
+	std::string payload;
+	for (auto iter = p_map.cbegin(); iter != p_map.cend(); ++iter) {
+		MapFileEntry entry;
+		entry.m_hash = static_cast<uint64_t>(iter.GetPtr()->m_hash);
+		payload.resize((payload.size() + 7) / 8 * 8, '\0');
+		entry.m_key_offset = payload.size();
+		Serializer<_KeyType>::Write(payload, iter->first);
+		entry.m_key_size = static_cast<uint32_t>(payload.size() - entry.m_key_offset);
+		payload.resize((payload.size() + 7) / 8 * 8, '\0');
+		entry.m_value_offset = payload.size();
+		Serializer<_DataType>::Write(payload, iter->second);
+		entry.m_value_size = static_cast<uint32_t>(payload.size() - entry.m_value_offset);
+		unordered.push_back(entry);
+		buckets.push_back(policy.Index(iter.GetPtr()->m_hash));
+		bucket_starts[buckets.back() + 1]++;
+	}
+	// Раскладка записей по корзинам подсчетом.
+	for (size_t i = 0; i < header.m_buckets; i++) {
+		bucket_starts[i + 1] += bucket_starts[i];
+	}
+	std::vector<MapFileEntry> entries(unordered.size());
+	std::vector<uint64_t> next(bucket_starts.begin(), bucket_starts.end() - 1);
+	for (size_t i = 0; i < unordered.size(); i++) {
+		entries[next[buckets[i]]++] = unordered[i];
+	}
+
+	header.m_buckets_offset = sizeof(MapFileHeader);
+	header.m_entries_offset = header.m_buckets_offset + bucket_starts.size() * sizeof(uint64_t);
+	header.m_payload_offset = header.m_entries_offset + entries.size() * sizeof(MapFileEntry);
+	header.m_file_size = header.m_payload_offset + payload.size();
+
+	std::ofstream out(p_path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw FileError("FileError: cannot open file '" + p_path + "' for writing.");
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(bucket_starts.data()), bucket_starts.size() * sizeof(uint64_t));
+	out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MapFileEntry));
+	out.write(payload.data(), payload.size());
+	if (!out.flush()) {
+		throw FileError("FileError: cannot write file '" + p_path + "'.");
+	}
+}
+
+
+/*
+Заменяет содержимое p_map элементами из файла p_path. Массив корзин сразу получает сохраненный размер,
+а элементы вставляются одной пачкой с сохраненными хэшами (InsertRange). Хэш-функция, предикат и источник
+памяти p_map сохраняются. Совпадение хэш-функции p_map с записавшей файл проверяется только по первому элементу:
+остальным сохраненным хэшам контейнер верит, и в поврежденном файле с неверными хэшами элементы не будут находиться.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash, typename _KeyEqual, typename _BucketPolicy>
+void loadUnorderedMap(UnorderedMap<_KeyType, _DataType, _Hash, _KeyEqual, _BucketPolicy>& p_map, const std::string& p_path) {
+	using PairType = std::pair<const _KeyType, _DataType>;
+	MappedFile file(p_path);
+	const MapFileHeader& header = checkMapFile(file.GetData(), file.GetSize());
+	const MapFileEntry* entries = reinterpret_cast<const MapFileEntry*>(file.GetData() + header.m_entries_offset);
+	const char* payload = file.GetData() + header.m_payload_offset;
+	size_t payload_size = static_cast<size_t>(header.m_file_size - header.m_payload_offset);
+
+	std::vector<PairType> pairs;
+	std::vector<size_t> hashes;
+	pairs.reserve(header.m_size);
+	hashes.reserve(header.m_size);
+	for (size_t i = 0; i < header.m_size; i++) {
+		const MapFileEntry& entry = entries[i];
+		if (!inPayload(entry.m_key_offset, entry.m_key_size, payload_size) || !inPayload(entry.m_value_offset, entry.m_value_size, payload_size)) {
+			throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+		}
+		pairs.emplace_back(Serializer<_KeyType>::Read(payload + entry.m_key_offset, entry.m_key_size),
+			Serializer<_DataType>::Read(payload + entry.m_value_offset, entry.m_value_size));
+		hashes.push_back(static_cast<size_t>(entry.m_hash));
+	}
+	if (!pairs.empty() && p_map.GetHashFunction()(pairs.front().first) != hashes.front()) {
+		throw InvalidValueError("InvalidValueError: file was written with a different hash function.");
+	}
+	p_map.MaxLoadFactor(header.m_max_load_factor);
+	p_map.Clear();
+	p_map.SetBucketCount(static_cast<int>(header.m_map_buckets));
+	p_map.InsertRange(std::make_move_iterator(pairs.begin()), std::make_move_iterator(pairs.end()), hashes.begin());
+}
+
+
+/*
+Контейнер только для чтения поверх файла saveUnorderedMap, отображенного в память. Открытие не читает элементы,
+Find и ForEach работают прямо с байтами файла и отдают представления Serializer::View (например, std::string_view
+вместо std::string), действительные, пока существует контейнер. Ключи сравниваются через ==
+представления ключа с искомым ключом.
+*/
+template<typename _KeyType, typename _DataType, typename _Hash = std::hash<_KeyType>>
+class MappedUnorderedMap {
+public:
+	using KeyView = typename Serializer<_KeyType>::ViewType;
+	using ValueView = typename Serializer<_DataType>::ViewType;
+
+private:
+	MappedFile m_file;
+	const MapFileHeader* m_header;
+	const uint64_t* m_bucket_starts;
+	const MapFileEntry* m_entries;
+	const char* m_payload;
+	size_t m_payload_size;
+	PowerOfTwoBucketPolicy m_policy;
+	_Hash m_hash_obj;
+
+	const char* Payload(uint64_t p_offset, uint32_t p_size) const {
+		if (!inPayload(p_offset, p_size, m_payload_size)) {
+			throw InvalidValueError("InvalidValueError: corrupted serialized data.");
+		}
+		return m_payload + p_offset;
+	}
+
+	KeyView Key(const MapFileEntry& p_entry) const {
+		return Serializer<_KeyType>::View(Payload(p_entry.m_key_offset, p_entry.m_key_size), p_entry.m_key_size);
+	}
+
+	ValueView Value(const MapFileEntry& p_entry) const {
+		return Serializer<_DataType>::View(Payload(p_entry.m_value_offset, p_entry.m_value_size), p_entry.m_value_size);
+	}
+
+	const MapFileEntry* FindEntry(const _KeyType& p_key) const {
+		size_t hash = m_hash_obj(p_key);
+		int bucket = m_policy.Index(hash);
+		uint64_t last = m_bucket_starts[bucket + 1] < m_header->m_size ? m_bucket_starts[bucket + 1] : m_header->m_size;
+		for (uint64_t i = m_bucket_starts[bucket]; i < last; i++) {
+			const MapFileEntry& entry = m_entries[i];
+			if (entry.m_hash == hash && Key(entry) == p_key) {
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+public:
+	explicit MappedUnorderedMap(const std::string& p_path) : m_file(p_path) {
+		m_header = &checkMapFile(m_file.GetData(), m_file.GetSize());
+		m_bucket_starts = reinterpret_cast<const uint64_t*>(m_file.GetData() + m_header->m_buckets_offset);
+		m_entries = reinterpret_cast<const MapFileEntry*>(m_file.GetData() + m_header->m_entries_offset);
+		m_payload = m_file.GetData() + m_header->m_payload_offset;
+		m_payload_size = static_cast<size_t>(m_header->m_file_size - m_header->m_payload_offset);
+		m_policy.Reset(static_cast<int>(m_header->m_buckets));
+		if (m_header->m_size && m_hash_obj(Serializer<_KeyType>::Read(Payload(m_entries[0].m_key_offset, m_entries[0].m_key_size),
+			m_entries[0].m_key_size)) != m_entries[0].m_hash) {
+			throw InvalidValueError("InvalidValueError: file was written with a different hash function.");
+		}
+	}
+
+	std::optional<ValueView> Find(const _KeyType& p_key) const {
+		const MapFileEntry* entry = FindEntry(p_key);
+		if (!entry) {
+			return std::nullopt;
+		}
+		return Value(*entry);
+	}
+
+	ValueView At(const _KeyType& p_key) const {
+		const MapFileEntry* entry = FindEntry(p_key);
+		if (!entry) {
+			throw ItemNotFoundError("ItemNotFoundError: element with such key is not present in the container.");
+		}
+		return Value(*entry);
+	}
+
+	bool Contains(const _KeyType& p_key) const {
+		return FindEntry(p_key) != nullptr;
+	}
+
+	// Вызывает p_func(KeyView, ValueView) для каждого элемента в порядке корзин файла.
+	template<typename _Func>
+	void ForEach(_Func p_func) const {
+		for (uint64_t i = 0; i < m_header->m_size; i++) {
+			p_func(Key(m_entries[i]), Value(m_entries[i]));
+		}
+	}
+
+	int Size() const {
+		return static_cast<int>(m_header->m_size);
+	}
+
+	bool Empty() const {
+		return m_header->m_size == 0;
+	}
+
+	int GetBucketCount() const {
+		return static_cast<int>(m_header->m_buckets);
+	}
+};
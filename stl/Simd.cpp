@@ -0,0 +1,227 @@
+#include "Simd.h"
+#include "SimdKernels.h"
+#ifdef STL_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+
+#ifdef STL_SIMD_X86
+
+// Ядра AVX2 из SimdAvx2.cpp (явно инстанцированы для double, float, int32_t и uint32_t).
+template<typename _Type>
+bool avx2MinMax(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max);
+
+template<typename _Type>
+size_t avx2FindEqual(const _Type* p_data, size_t p_size, _Type p_value);
+
+template<typename _Type>
+size_t avx2FindInRange(const _Type* p_data, size_t p_size, _Type p_low, _Type p_high);
+
+
+namespace {
+
+bool DetectAvx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return os_saves_avx && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool HasAvx2() {
+	static const bool has_avx2 = DetectAvx2();
+	return has_avx2;
+}
+
+
+// Операции SSE2 (есть на любом x86-64).
+template<typename _Type>
+struct Sse2Ops;
+
+template<>
+struct Sse2Ops<double> {
+	using Vec = __m128d;
+	static constexpr size_t kLanes = 2;
+	static constexpr bool kHasNan = true;
+
+	static Vec Load(const double* p_data) { return _mm_loadu_pd(p_data); }
+	static Vec Set(double p_value) { return _mm_set1_pd(p_value); }
+	static void Store(double* p_data, Vec p_vec) { _mm_storeu_pd(p_data, p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm_min_pd(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm_max_pd(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm_or_pd(p_a, p_b); }
+	static Vec NanMask(Vec p_vec) { return _mm_cmpunord_pd(p_vec, p_vec); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm_movemask_pd(p_vec)); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm_cmpeq_pd(p_vec, p_value)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return Mask(_mm_and_pd(_mm_cmpge_pd(p_vec, p_low), _mm_cmple_pd(p_vec, p_high)));
+	}
+};
+
+template<>
+struct Sse2Ops<float> {
+	using Vec = __m128;
+	static constexpr size_t kLanes = 4;
+	static constexpr bool kHasNan = true;
+
+	static Vec Load(const float* p_data) { return _mm_loadu_ps(p_data); }
+	static Vec Set(float p_value) { return _mm_set1_ps(p_value); }
+	static void Store(float* p_data, Vec p_vec) { _mm_storeu_ps(p_data, p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm_min_ps(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm_max_ps(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm_or_ps(p_a, p_b); }
+	static Vec NanMask(Vec p_vec) { return _mm_cmpunord_ps(p_vec, p_vec); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm_movemask_ps(p_vec)); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm_cmpeq_ps(p_vec, p_value)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return Mask(_mm_and_ps(_mm_cmpge_ps(p_vec, p_low), _mm_cmple_ps(p_vec, p_high)));
+	}
+};
+
+// В SSE2 нет min/max для 32-битных целых: они собираются из сравнения и выбора по маске.
+template<>
+struct Sse2Ops<int32_t> {
+	using Vec = __m128i;
+	static constexpr size_t kLanes = 4;
+	static constexpr bool kHasNan = false;
+
+	static Vec Load(const int32_t* p_data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_data)); }
+	static Vec Set(int32_t p_value) { return _mm_set1_epi32(p_value); }
+	static void Store(int32_t* p_data, Vec p_vec) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p_data), p_vec); }
+	static Vec Select(Vec p_mask, Vec p_a, Vec p_b) { return _mm_or_si128(_mm_and_si128(p_mask, p_a), _mm_andnot_si128(p_mask, p_b)); }
+	static Vec Min(Vec p_a, Vec p_b) { return Select(_mm_cmpgt_epi32(p_a, p_b), p_b, p_a); }
+	static Vec Max(Vec p_a, Vec p_b) { return Select(_mm_cmpgt_epi32(p_a, p_b), p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm_or_si128(p_a, p_b); }
+	static Vec NanMask(Vec) { return _mm_setzero_si128(); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(p_vec))); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm_cmpeq_epi32(p_vec, p_value)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return ~Mask(_mm_or_si128(_mm_cmplt_epi32(p_vec, p_low), _mm_cmpgt_epi32(p_vec, p_high))) & 0xF;
+	}
+};
+
+// Беззнаковые сравниваются как знаковые после инверсии старшего бита.
+template<>
+struct Sse2Ops<uint32_t> {
+	using Vec = __m128i;
+	using Signed = Sse2Ops<int32_t>;
+	static constexpr size_t kLanes = 4;
+	static constexpr bool kHasNan = false;
+
+	static Vec Bias(Vec p_vec) { return _mm_xor_si128(p_vec, _mm_set1_epi32(INT32_MIN)); }
+	static Vec Load(const uint32_t* p_data) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_data)); }
+	static Vec Set(uint32_t p_value) { return _mm_set1_epi32(static_cast<int32_t>(p_value)); }
+	static void Store(uint32_t* p_data, Vec p_vec) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p_data), p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return Bias(Signed::Min(Bias(p_a), Bias(p_b))); }
+	static Vec Max(Vec p_a, Vec p_b) { return Bias(Signed::Max(Bias(p_a), Bias(p_b))); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm_or_si128(p_a, p_b); }
+	static Vec NanMask(Vec) { return _mm_setzero_si128(); }
+	static unsigned Mask(Vec p_vec) { return Signed::Mask(p_vec); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Signed::EqualMask(p_vec, p_value); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) { return Signed::InRangeMask(Bias(p_vec), Bias(p_low), Bias(p_high)); }
+};
+
+}
+
+
+template<typename _Type>
+bool minMaxImpl(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max) {
+	if (HasAvx2()) {
+		return avx2MinMax(p_data, p_size, p_min, p_max);
+	}
+	return minMaxKernel<Sse2Ops<_Type>>(p_data, p_size, p_min, p_max);
+}
+
+template<typename _Type>
+size_t findEqualImpl(const _Type* p_data, size_t p_size, _Type p_value) {
+	if (HasAvx2()) {
+		return avx2FindEqual(p_data, p_size, p_value);
+	}
+	return findEqualKernel<Sse2Ops<_Type>>(p_data, p_size, p_value);
+}
+
+template<typename _Type>
+size_t findInRangeImpl(const _Type* p_data, size_t p_size, _Type p_low, _Type p_high) {
+	if (HasAvx2()) {
+		return avx2FindInRange(p_data, p_size, p_low, p_high);
+	}
+	return findInRangeKernel<Sse2Ops<_Type>>(p_data, p_size, p_low, p_high);
+}
+
+#else
+
+template<typename _Type>
+bool minMaxImpl(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max) {
+	return scalarMinMax(p_data, p_size, p_min, p_max);
+}
+
+template<typename _Type>
+size_t findEqualImpl(const _Type* p_data, size_t p_size, _Type p_value) {
+	return scalarFindEqual(p_data, 0, p_size, p_value);
+}
+
+template<typename _Type>
+size_t findInRangeImpl(const _Type* p_data, size_t p_size, _Type p_low, _Type p_high) {
+	return scalarFindInRange(p_data, 0, p_size, p_low, p_high);
+}
+
+#endif
+
+
+bool simdMinMax(const double* p_data, size_t p_size, double& p_min, double& p_max) {
+	return minMaxImpl(p_data, p_size, p_min, p_max);
+}
+
+bool simdMinMax(const float* p_data, size_t p_size, float& p_min, float& p_max) {
+	return minMaxImpl(p_data, p_size, p_min, p_max);
+}
+
+bool simdMinMax(const int32_t* p_data, size_t p_size, int32_t& p_min, int32_t& p_max) {
+	return minMaxImpl(p_data, p_size, p_min, p_max);
+}
+
+bool simdMinMax(const uint32_t* p_data, size_t p_size, uint32_t& p_min, uint32_t& p_max) {
+	return minMaxImpl(p_data, p_size, p_min, p_max);
+}
+
+
+size_t simdFindEqual(const double* p_data, size_t p_size, double p_value) {
+	return findEqualImpl(p_data, p_size, p_value);
+}
+
+size_t simdFindEqual(const float* p_data, size_t p_size, float p_value) {
+	return findEqualImpl(p_data, p_size, p_value);
+}
+
+size_t simdFindEqual(const int32_t* p_data, size_t p_size, int32_t p_value) {
+	return findEqualImpl(p_data, p_size, p_value);
+}
+
+size_t simdFindEqual(const uint32_t* p_data, size_t p_size, uint32_t p_value) {
+	return findEqualImpl(p_data, p_size, p_value);
+}
+
+
+size_t simdFindInRange(const double* p_data, size_t p_size, double p_low, double p_high) {
+	return findInRangeImpl(p_data, p_size, p_low, p_high);
+}
+
+size_t simdFindInRange(const float* p_data, size_t p_size, float p_low, float p_high) {
+	return findInRangeImpl(p_data, p_size, p_low, p_high);
+}
+
+size_t simdFindInRange(const int32_t* p_data, size_t p_size, int32_t p_low, int32_t p_high) {
+	return findInRangeImpl(p_data, p_size, p_low, p_high);
+}
+
+size_t simdFindInRange(const uint32_t* p_data, size_t p_size, uint32_t p_low, uint32_t p_high) {
+	return findInRangeImpl(p_data, p_size, p_low, p_high);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STL_SIMD_X86 1
+#endif
+
+
+/*
+Векторные ядра для minElement, maxElement, minMaxElement и findIf на непрерывных диапазонах (указателях)
+элементов double, float, int32_t и uint32_t. Набор инструкций (AVX2 или SSE2) выбирается один раз во время
+выполнения по возможностям процессора; на других архитектурах работают скалярные циклы.
+*/
+
+// Предикаты findIf, для которых есть векторная реализация; с остальными итераторами работают как обычные функторы.
+template<typename _Type>
+struct EqualTo {
+	_Type m_value;
+
+	bool operator()(const _Type& p_value) const {
+		return p_value == m_value;
+	}
+};
+
+// Включительно с обеих сторон: m_low <= x <= m_high.
+template<typename _Type>
+struct InRange {
+	_Type m_low;
+	_Type m_high;
+
+	bool operator()(const _Type& p_value) const {
+		return m_low <= p_value && p_value <= m_high;
+	}
+};
+
+
+template<typename _Type>
+struct IsSimdType : std::integral_constant<bool, std::is_same<_Type, double>::value || std::is_same<_Type, float>::value ||
+	std::is_same<_Type, int32_t>::value || std::is_same<_Type, uint32_t>::value> {};
+
+template<typename _Iter>
+struct IsSimdRange : std::false_type {};
+
+template<typename _Type>
+struct IsSimdRange<_Type*> : IsSimdType<typename std::remove_cv<_Type>::type> {};
+
+
+/*
+Минимум и максимум непустого диапазона. Возвращает false, если в диапазоне есть NaN: векторные min/max
+обрабатывают его не так, как сравнения скалярных циклов, поэтому результат тогда определяет скалярный алгоритм.
+*/
+bool simdMinMax(const double* p_data, size_t p_size, double& p_min, double& p_max);
+bool simdMinMax(const float* p_data, size_t p_size, float& p_min, float& p_max);
+bool simdMinMax(const int32_t* p_data, size_t p_size, int32_t& p_min, int32_t& p_max);
+bool simdMinMax(const uint32_t* p_data, size_t p_size, uint32_t& p_min, uint32_t& p_max);
+
+// Индекс первого элемента, равного p_value, или p_size.
+size_t simdFindEqual(const double* p_data, size_t p_size, double p_value);
+size_t simdFindEqual(const float* p_data, size_t p_size, float p_value);
+size_t simdFindEqual(const int32_t* p_data, size_t p_size, int32_t p_value);
+size_t simdFindEqual(const uint32_t* p_data, size_t p_size, uint32_t p_value);
+
+// Индекс первого элемента из [p_low, p_high], или p_size.
+size_t simdFindInRange(const double* p_data, size_t p_size, double p_low, double p_high);
+size_t simdFindInRange(const float* p_data, size_t p_size, float p_low, float p_high);
+size_t simdFindInRange(const int32_t* p_data, size_t p_size, int32_t p_low, int32_t p_high);
+size_t simdFindInRange(const uint32_t* p_data, size_t p_size, uint32_t p_low, uint32_t p_high);
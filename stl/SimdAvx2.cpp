@@ -0,0 +1,139 @@
+#include "Simd.h"
+#ifdef STL_SIMD_X86
+#include <immintrin.h>
+
+/*
+Ядра AVX2. Файл целиком компилируется под AVX2 без отдельных флагов сборки (MSVC разрешает AVX2-интринсики и так),
+а вызывается из Simd.cpp только после проверки процессора.
+*/
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+#include "SimdKernels.h"
+
+
+namespace {
+
+template<typename _Type>
+struct Avx2Ops;
+
+template<>
+struct Avx2Ops<double> {
+	using Vec = __m256d;
+	static constexpr size_t kLanes = 4;
+	static constexpr bool kHasNan = true;
+
+	static Vec Load(const double* p_data) { return _mm256_loadu_pd(p_data); }
+	static Vec Set(double p_value) { return _mm256_set1_pd(p_value); }
+	static void Store(double* p_data, Vec p_vec) { _mm256_storeu_pd(p_data, p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm256_min_pd(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm256_max_pd(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm256_or_pd(p_a, p_b); }
+	static Vec NanMask(Vec p_vec) { return _mm256_cmp_pd(p_vec, p_vec, _CMP_UNORD_Q); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm256_movemask_pd(p_vec)); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm256_cmp_pd(p_vec, p_value, _CMP_EQ_OQ)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return Mask(_mm256_and_pd(_mm256_cmp_pd(p_vec, p_low, _CMP_GE_OQ), _mm256_cmp_pd(p_vec, p_high, _CMP_LE_OQ)));
+	}
+};
+
+template<>
+struct Avx2Ops<float> {
+	using Vec = __m256;
+	static constexpr size_t kLanes = 8;
+	static constexpr bool kHasNan = true;
+
+	static Vec Load(const float* p_data) { return _mm256_loadu_ps(p_data); }
+	static Vec Set(float p_value) { return _mm256_set1_ps(p_value); }
+	static void Store(float* p_data, Vec p_vec) { _mm256_storeu_ps(p_data, p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm256_min_ps(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm256_max_ps(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm256_or_ps(p_a, p_b); }
+	static Vec NanMask(Vec p_vec) { return _mm256_cmp_ps(p_vec, p_vec, _CMP_UNORD_Q); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm256_movemask_ps(p_vec)); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm256_cmp_ps(p_vec, p_value, _CMP_EQ_OQ)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return Mask(_mm256_and_ps(_mm256_cmp_ps(p_vec, p_low, _CMP_GE_OQ), _mm256_cmp_ps(p_vec, p_high, _CMP_LE_OQ)));
+	}
+};
+
+template<>
+struct Avx2Ops<int32_t> {
+	using Vec = __m256i;
+	static constexpr size_t kLanes = 8;
+	static constexpr bool kHasNan = false;
+
+	static Vec Load(const int32_t* p_data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_data)); }
+	static Vec Set(int32_t p_value) { return _mm256_set1_epi32(p_value); }
+	static void Store(int32_t* p_data, Vec p_vec) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_data), p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm256_min_epi32(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm256_max_epi32(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm256_or_si256(p_a, p_b); }
+	static Vec NanMask(Vec) { return _mm256_setzero_si256(); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(p_vec))); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm256_cmpeq_epi32(p_vec, p_value)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return ~Mask(_mm256_or_si256(_mm256_cmpgt_epi32(p_low, p_vec), _mm256_cmpgt_epi32(p_vec, p_high))) & 0xFF;
+	}
+};
+
+// Для беззнаковых x >= low равносильно max(x, low) == x, а x <= high - min(x, high) == x.
+template<>
+struct Avx2Ops<uint32_t> {
+	using Vec = __m256i;
+	static constexpr size_t kLanes = 8;
+	static constexpr bool kHasNan = false;
+
+	static Vec Load(const uint32_t* p_data) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_data)); }
+	static Vec Set(uint32_t p_value) { return _mm256_set1_epi32(static_cast<int32_t>(p_value)); }
+	static void Store(uint32_t* p_data, Vec p_vec) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_data), p_vec); }
+	static Vec Min(Vec p_a, Vec p_b) { return _mm256_min_epu32(p_a, p_b); }
+	static Vec Max(Vec p_a, Vec p_b) { return _mm256_max_epu32(p_a, p_b); }
+	static Vec Or(Vec p_a, Vec p_b) { return _mm256_or_si256(p_a, p_b); }
+	static Vec NanMask(Vec) { return _mm256_setzero_si256(); }
+	static unsigned Mask(Vec p_vec) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(p_vec))); }
+	static unsigned EqualMask(Vec p_vec, Vec p_value) { return Mask(_mm256_cmpeq_epi32(p_vec, p_value)); }
+	static unsigned InRangeMask(Vec p_vec, Vec p_low, Vec p_high) {
+		return Mask(_mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(p_vec, p_low), p_vec),
+			_mm256_cmpeq_epi32(_mm256_min_epu32(p_vec, p_high), p_vec)));
+	}
+};
+
+}
+
+
+template<typename _Type>
+bool avx2MinMax(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max) {
+	return minMaxKernel<Avx2Ops<_Type>>(p_data, p_size, p_min, p_max);
+}
+
+template<typename _Type>
+size_t avx2FindEqual(const _Type* p_data, size_t p_size, _Type p_value) {
+	return findEqualKernel<Avx2Ops<_Type>>(p_data, p_size, p_value);
+}
+
+template<typename _Type>
+size_t avx2FindInRange(const _Type* p_data, size_t p_size, _Type p_low, _Type p_high) {
+	return findInRangeKernel<Avx2Ops<_Type>>(p_data, p_size, p_low, p_high);
+}
+
+template bool avx2MinMax<double>(const double*, size_t, double&, double&);
+template bool avx2MinMax<float>(const float*, size_t, float&, float&);
+template bool avx2MinMax<int32_t>(const int32_t*, size_t, int32_t&, int32_t&);
+template bool avx2MinMax<uint32_t>(const uint32_t*, size_t, uint32_t&, uint32_t&);
+template size_t avx2FindEqual<double>(const double*, size_t, double);
+template size_t avx2FindEqual<float>(const float*, size_t, float);
+template size_t avx2FindEqual<int32_t>(const int32_t*, size_t, int32_t);
+template size_t avx2FindEqual<uint32_t>(const uint32_t*, size_t, uint32_t);
+template size_t avx2FindInRange<double>(const double*, size_t, double, double);
+template size_t avx2FindInRange<float>(const float*, size_t, float, float);
+template size_t avx2FindInRange<int32_t>(const int32_t*, size_t, int32_t, int32_t);
+template size_t avx2FindInRange<uint32_t>(const uint32_t*, size_t, uint32_t, uint32_t);
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
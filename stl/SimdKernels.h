@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/*
+Общие циклы векторных ядер; подключается только из Simd.cpp и SimdAvx2.cpp. _Ops задает регистр (Vec) из kLanes
+элементов и операции над ним. Все определения - в безымянном пространстве имен: файлы компилируются под разные
+наборы инструкций, и одноименные inline-функции не должны склеиваться компоновщиком.
+*/
+namespace {
+
+inline int lowestBit(unsigned p_mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, p_mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(p_mask);
+#endif
+}
+
+template<typename _Type>
+bool scalarMinMax(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max) {
+	p_min = p_max = p_data[0];
+	for (size_t i = 0; i < p_size; i++) {
+		if (p_data[i] != p_data[i]) {
+			return false;
+		}
+		if (p_data[i] < p_min) {
+			p_min = p_data[i];
+		}
+		if (p_data[i] > p_max) {
+			p_max = p_data[i];
+		}
+	}
+	return true;
+}
+
+template<typename _Type>
+size_t scalarFindEqual(const _Type* p_data, size_t p_begin, size_t p_size, _Type p_value) {
+	for (size_t i = p_begin; i < p_size; i++) {
+		if (p_data[i] == p_value) {
+			return i;
+		}
+	}
+	return p_size;
+}
+
+template<typename _Type>
+size_t scalarFindInRange(const _Type* p_data, size_t p_begin, size_t p_size, _Type p_low, _Type p_high) {
+	for (size_t i = p_begin; i < p_size; i++) {
+		if (p_low <= p_data[i] && p_data[i] <= p_high) {
+			return i;
+		}
+	}
+	return p_size;
+}
+
+// Хвост короче регистра обрабатывается повторной загрузкой последних kLanes элементов (min/max от повтора не меняются).
+template<typename _Ops, typename _Type>
+bool minMaxKernel(const _Type* p_data, size_t p_size, _Type& p_min, _Type& p_max) {
+	using Vec = typename _Ops::Vec;
+	const size_t kLanes = _Ops::kLanes;
+	if (p_size < kLanes) {
+		return scalarMinMax(p_data, p_size, p_min, p_max);
+	}
+	Vec min_vec = _Ops::Load(p_data);
+	Vec max_vec = min_vec;
+	Vec nan_vec = _Ops::NanMask(min_vec);
+	size_t i = kLanes;
+	for (; i + kLanes <= p_size; i += kLanes) {
+		Vec value = _Ops::Load(p_data + i);
+		min_vec = _Ops::Min(min_vec, value);
+		max_vec = _Ops::Max(max_vec, value);
+		if constexpr (_Ops::kHasNan) {
+			nan_vec = _Ops::Or(nan_vec, _Ops::NanMask(value));
+		}
+	}
+	if (i < p_size) {
+		Vec value = _Ops::Load(p_data + p_size - kLanes);
+		min_vec = _Ops::Min(min_vec, value);
+		max_vec = _Ops::Max(max_vec, value);
+		if constexpr (_Ops::kHasNan) {
+			nan_vec = _Ops::Or(nan_vec, _Ops::NanMask(value));
+		}
+	}
+	if constexpr (_Ops::kHasNan) {
+		if (_Ops::Mask(nan_vec)) {
+			return false;
+		}
+	}
+	_Type mins[kLanes], maxs[kLanes];
+	_Ops::Store(mins, min_vec);
+	_Ops::Store(maxs, max_vec);
+	p_min = mins[0];
+	p_max = maxs[0];
+	for (size_t lane = 1; lane < kLanes; lane++) {
+		if (mins[lane] < p_min) {
+			p_min = mins[lane];
+		}
+		if (maxs[lane] > p_max) {
+			p_max = maxs[lane];
+		}
+	}
+	return true;
+}
+
+template<typename _Ops, typename _Type>
+size_t findEqualKernel(const _Type* p_data, size_t p_size, _Type p_value) {
+	using Vec = typename _Ops::Vec;
+	const size_t kLanes = _Ops::kLanes;
+	Vec value = _Ops::Set(p_value);
+	size_t i = 0;
+	for (; i + kLanes <= p_size; i += kLanes) {
+		unsigned mask = _Ops::EqualMask(_Ops::Load(p_data + i), value);
+		if (mask) {
+			return i + lowestBit(mask);
+		}
+	}
+	return scalarFindEqual(p_data, i, p_size, p_value);
+}
+
+template<typename _Ops, typename _Type>
+size_t findInRangeKernel(const _Type* p_data, size_t p_size, _Type p_low, _Type p_high) {
+	using Vec = typename _Ops::Vec;
+	const size_t kLanes = _Ops::kLanes;
+	Vec low = _Ops::Set(p_low);
+	Vec high = _Ops::Set(p_high);
+	size_t i = 0;
+	for (; i + kLanes <= p_size; i += kLanes) {
+		unsigned mask = _Ops::InRangeMask(_Ops::Load(p_data + i), low, high);
+		if (mask) {
+			return i + lowestBit(mask);
+		}
+	}
+	return scalarFindInRange(p_data, i, p_size, p_low, p_high);
+}
+
+}
@@ -0,0 +1,39 @@
+#include "Stats.h"
+#include <sstream>
+
+
+namespace {
+
+void writeHistogram(std::ostringstream& p_out, const char* p_name, const uint64_t* p_bins) {
+	p_out << ",\"" << p_name << "\":[";
+	for (int i = 0; i < MapStats::kHistogramSize; i++) {
+		p_out << (i ? "," : "") << p_bins[i];
+	}
+	p_out << "]";
+}
+
+}
+
+
+std::string MapStats::ToJson() const {
+	std::ostringstream out;
+	out << "{\"enabled\":" << (m_enabled ? "true" : "false")
+		<< ",\"size\":" << m_size
+		<< ",\"buckets\":" << m_buckets
+		<< ",\"old_buckets\":" << m_old_buckets
+		<< ",\"load_factor\":" << m_load_factor;
+	writeHistogram(out, "chain_histogram", m_chain_histogram);
+	out << ",\"max_chain\":" << m_max_chain
+		<< ",\"node_bytes\":" << m_node_bytes
+		<< ",\"table_bytes\":" << m_table_bytes
+		<< ",\"inserts\":" << m_inserts
+		<< ",\"lookups\":" << m_lookups
+		<< ",\"misses\":" << m_misses
+		<< ",\"erases\":" << m_erases;
+	writeHistogram(out, "probe_histogram", m_probe_histogram);
+	out << ",\"rehashes\":" << m_rehashes
+		<< ",\"rehash_nanoseconds\":" << m_rehash_nanoseconds
+		<< ",\"max_rehash_nanoseconds\":" << m_max_rehash_nanoseconds
+		<< "}";
+	return out.str();
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+
+/*
+Статистика UnorderedMap. Счетчики горячего пути (поиски, вставки, удаления, перестройки) собираются только
+при STL_MAP_STATS = 1; по умолчанию макрос равен 0 и все обращения к ним исчезают при компиляции (STL_MAP_STAT).
+Снимок структуры (гистограмма длин цепочек, память) строится по запросу GetStats и доступен всегда.
+*/
+#ifndef STL_MAP_STATS
+#define STL_MAP_STATS 0
+#endif
+
+#if STL_MAP_STATS
+#define STL_MAP_STAT(p_statement) p_statement
+#else
+#define STL_MAP_STAT(p_statement)
+#endif
+
+
+struct MapStats {
+	static constexpr int kHistogramSize = 16;    // последняя ячейка гистограмм - kHistogramSize - 1 и больше
+
+	bool m_enabled = STL_MAP_STATS != 0;         // собирались ли счетчики горячего пути
+
+	// Снимок структуры.
+	uint64_t m_size = 0;
+	uint64_t m_buckets = 0;
+	uint64_t m_old_buckets = 0;                  // массив незавершенного постепенного перехэширования
+	double m_load_factor = 0;
+	uint64_t m_chain_histogram[kHistogramSize] = {};    // число корзин по длине цепочки
+	uint64_t m_max_chain = 0;
+	uint64_t m_node_bytes = 0;                   // память слэбов пула узлов
+	uint64_t m_table_bytes = 0;
+
+	// Счетчики с момента создания контейнера или ResetStats.
+	uint64_t m_inserts = 0;
+	uint64_t m_lookups = 0;                      // только поиски на чтение: Find, At, TryGet, Contains, Count, FindMany, TryGetMany
+	uint64_t m_misses = 0;
+	uint64_t m_erases = 0;
+	uint64_t m_probe_histogram[kHistogramSize] = {};    // число поисков по числу просмотренных узлов
+	uint64_t m_rehashes = 0;
+	uint64_t m_rehash_nanoseconds = 0;
+	uint64_t m_max_rehash_nanoseconds = 0;       // самая долгая одиночная перестройка (или шаг постепенной)
+
+	// Однострочный JSON с теми же именами полей без префикса m_.
+	std::string ToJson() const;
+};
+
+
+// Счетчики горячего пути. Атомарны (relaxed): константные поиски могут идти из нескольких потоков одновременно.
+class MapCounters {
+private:
+	std::atomic<uint64_t> m_inserts;
+	std::atomic<uint64_t> m_lookups;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_erases;
+	std::atomic<uint64_t> m_probe_histogram[MapStats::kHistogramSize];
+	std::atomic<uint64_t> m_rehashes;
+	std::atomic<uint64_t> m_rehash_nanoseconds;
+	std::atomic<uint64_t> m_max_rehash_nanoseconds;
+
+	static void Add(std::atomic<uint64_t>& p_counter, uint64_t p_value = 1) {
+		p_counter.fetch_add(p_value, std::memory_order_relaxed);
+	}
+public:
+	// Засекает длительность перестройки от создания до разрушения.
+	class Timer {
+	private:
+		MapCounters& m_counters;
+		std::chrono::steady_clock::time_point m_start;
+	public:
+		explicit Timer(MapCounters& p_counters) : m_counters(p_counters), m_start(std::chrono::steady_clock::now()) {}
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		~Timer() {
+			auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+			m_counters.RecordRehashTime(static_cast<uint64_t>(elapsed));
+		}
+	};
+
+	MapCounters() {
+		Reset();
+	}
+
+	MapCounters(const MapCounters&) = delete;
+	MapCounters& operator=(const MapCounters&) = delete;
+
+	void Reset() {
+		m_inserts.store(0, std::memory_order_relaxed);
+		m_lookups.store(0, std::memory_order_relaxed);
+		m_misses.store(0, std::memory_order_relaxed);
+		m_erases.store(0, std::memory_order_relaxed);
+		for (auto& bin : m_probe_histogram) {
+			bin.store(0, std::memory_order_relaxed);
+		}
+		m_rehashes.store(0, std::memory_order_relaxed);
+		m_rehash_nanoseconds.store(0, std::memory_order_relaxed);
+		m_max_rehash_nanoseconds.store(0, std::memory_order_relaxed);
+	}
+
+	void RecordLookup(int p_probes, bool p_found) {
+		Add(m_lookups);
+		if (!p_found) {
+			Add(m_misses);
+		}
+		Add(m_probe_histogram[p_probes < MapStats::kHistogramSize ? p_probes : MapStats::kHistogramSize - 1]);
+	}
+
+	void RecordInsert() {
+		Add(m_inserts);
+	}
+
+	void RecordErase() {
+		Add(m_erases);
+	}
+
+	void RecordRehash() {
+		Add(m_rehashes);
+	}
+
+	void RecordRehashTime(uint64_t p_nanoseconds) {
+		Add(m_rehash_nanoseconds, p_nanoseconds);
+		uint64_t max = m_max_rehash_nanoseconds.load(std::memory_order_relaxed);
+		while (p_nanoseconds > max && !m_max_rehash_nanoseconds.compare_exchange_weak(max, p_nanoseconds, std::memory_order_relaxed)) {}
+	}
+
+	void CopyTo(MapStats& p_stats) const {
+		p_stats.m_inserts = m_inserts.load(std::memory_order_relaxed);
+		p_stats.m_lookups = m_lookups.load(std::memory_order_relaxed);
+		p_stats.m_misses = m_misses.load(std::memory_order_relaxed);
+		p_stats.m_erases = m_erases.load(std::memory_order_relaxed);
+		for (int i = 0; i < MapStats::kHistogramSize; i++) {
+			p_stats.m_probe_histogram[i] = m_probe_histogram[i].load(std::memory_order_relaxed);
+		}
+		p_stats.m_rehashes = m_rehashes.load(std::memory_order_relaxed);
+		p_stats.m_rehash_nanoseconds = m_rehash_nanoseconds.load(std::memory_order_relaxed);
+		p_stats.m_max_rehash_nanoseconds = m_max_rehash_nanoseconds.load(std::memory_order_relaxed);
+	}
+};
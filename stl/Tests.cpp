@@ -0,0 +1,432 @@
+#include "Algorithms.h"
+#include "ConcurrentContainer.h"
+#include "Container.h"
+#include "FlatContainer.h"
+#include "FrozenContainer.h"
+#include "Index.h"
+#include "Intern.h"
+#include "PersistentContainer.h"
+#include "ReadMostlyContainer.h"
+#include "Serialization.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Smoke tests: every container and algorithm is instantiated and checked on small inputs, including exception paths.
+// Run by ctest; the exit code is the number of failed checks.
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool p_ok, const char* p_expr, int p_line) {
+	if (!p_ok) {
+		std::printf("FAILED line %d: %s\n", p_line, p_expr);
+		g_failures++;
+	}
+}
+
+#define STL_CHECK(p_expr) check((p_expr), #p_expr, __LINE__)
+
+template<typename _Exception, typename _Func>
+bool throws(_Func p_func) {
+	try {
+		p_func();
+	}
+	catch (const _Exception&) {
+		return true;
+	}
+	return false;
+}
+
+
+// Value that counts live objects and can be told to throw from its copy constructor after a number of copies.
+struct Tracked {
+	static int s_live;
+	static int s_copies_left;    // -1 - never throw
+
+	int m_value;
+
+	Tracked(int p_value = 0) : m_value(p_value) {
+		s_live++;
+	}
+
+	Tracked(const Tracked& p_other) : m_value(p_other.m_value) {
+		if (s_copies_left >= 0 && s_copies_left-- == 0) {
+			throw std::runtime_error("copy");
+		}
+		s_live++;
+	}
+
+	Tracked& operator=(const Tracked& p_other) {
+		m_value = p_other.m_value;
+		return *this;
+	}
+
+	~Tracked() {
+		s_live--;
+	}
+};
+
+int Tracked::s_live = 0;
+int Tracked::s_copies_left = -1;
+
+
+// Hash that throws while s_throw is set.
+struct ThrowingHash {
+	static bool s_throw;
+
+	size_t operator()(int p_key) const {
+		if (s_throw) {
+			throw std::runtime_error("hash");
+		}
+		return std::hash<int>()(p_key);
+	}
+};
+
+bool ThrowingHash::s_throw = false;
+
+
+void testUnorderedMap() {
+	UnorderedMap<int, std::string> map;
+	for (int i = 0; i < 1000; i++) {
+		map.Insert({ i, std::to_string(i) });
+	}
+	STL_CHECK(map.Size() == 1000);
+	STL_CHECK(map.At(500) == "500");
+	STL_CHECK(throws<ItemNotFoundError>([&map] { map.At(5000); }));
+	map.Erase(500);
+	STL_CHECK(!map.Contains(500) && map.Count(501) == 1);
+	STL_CHECK(map.TryEmplace(500, "x").second && !map.TryEmplace(500, "y").second && map.At(500) == "x");
+	STL_CHECK(!map.InsertOrAssign(500, "z").second && map.At(500) == "z");
+	map[2000] = "2000";
+	STL_CHECK(map.Find(2000) != map.end() && *map.TryGet(2000) == "2000" && map.TryGet(3000) == nullptr);
+
+	std::vector<int> keys = { 1, 3000, 999 };
+	std::vector<UnorderedMap<int, std::string>::iterator> found(keys.size());
+	map.FindMany(keys.begin(), keys.end(), found.begin());
+	STL_CHECK(found[0]->second == "1" && found[1] == map.end() && found[2]->second == "999");
+	std::vector<std::string*> values(keys.size());
+	map.TryGetMany(keys.begin(), keys.end(), values.begin());
+	STL_CHECK(*values[0] == "1" && values[1] == nullptr);
+
+	UnorderedMap<int, std::string> copy(map);
+	STL_CHECK(copy.Size() == map.Size() && copy.At(999) == "999");
+	UnorderedMap<int, std::string> moved(std::move(copy));
+	STL_CHECK(moved.Size() == map.Size() && copy.Empty());
+
+	// Bulk and single inserts agree on the small-mode threshold.
+	std::vector<std::pair<const int, int>> pairs;
+	for (int i = 0; i < 8; i++) {
+		pairs.push_back({ i, i });
+	}
+	UnorderedMap<int, int> bulk;
+	bulk.InsertRange(pairs.begin(), pairs.end());
+	UnorderedMap<int, int> single;
+	for (auto& pair : pairs) {
+		single.Insert(pair);
+	}
+	STL_CHECK(bulk.GetBucketCount() == single.GetBucketCount());
+
+	// Reserve is not undone by the next insert; erasures let the table shrink.
+	UnorderedMap<int, int> shrinking;
+	shrinking.MinLoadFactor(0.1);
+	shrinking.Reserve(10000);
+	int reserved = shrinking.GetBucketCount();
+	for (int i = 0; i < 100; i++) {
+		shrinking.Insert({ i, i });
+	}
+	STL_CHECK(shrinking.GetBucketCount() == reserved);
+	for (int i = 0; i < 100; i++) {
+		shrinking.Erase(i);
+	}
+	shrinking.Insert({ 1, 1 });
+	STL_CHECK(shrinking.GetBucketCount() < reserved);
+	shrinking.ShrinkToFit();
+	STL_CHECK(shrinking.At(1) == 1);
+
+	UnorderedMap<int, int> incremental;
+	incremental.IncrementalRehash(true);
+	for (int i = 0; i < 5000; i++) {
+		incremental.Insert({ i, i });
+	}
+	bool all_found = true;
+	for (int i = 0; i < 5000; i++) {
+		all_found = all_found && incremental.At(i) == i;
+	}
+	STL_CHECK(all_found);
+	STL_CHECK(incremental.GetStats().m_size == 5000);
+}
+
+void testEmplaceExceptions() {
+	int live = Tracked::s_live;
+	{
+		UnorderedMap<int, Tracked, ThrowingHash> map;
+		for (int i = 0; i < 20; i++) {
+			map.Emplace(i, Tracked(i));
+		}
+		ThrowingHash::s_throw = true;
+		STL_CHECK(throws<std::runtime_error>([&map] { map.Emplace(100, Tracked(100)); }));
+		ThrowingHash::s_throw = false;
+		STL_CHECK(map.Size() == 20 && !map.Contains(100));
+		STL_CHECK(Tracked::s_live == live + 20);
+	}
+	STL_CHECK(Tracked::s_live == live);
+}
+
+void testFlatUnorderedMap() {
+	FlatUnorderedMap<std::string, int> map;
+	for (int i = 0; i < 1000; i++) {
+		map.Insert({ std::to_string(i), i });
+	}
+	STL_CHECK(map.Size() == 1000 && map.At("999") == 999);
+	map.Erase("999");
+	STL_CHECK(throws<ItemNotFoundError>([&map] { map.At("999"); }));
+	map["999"] = 1;
+	STL_CHECK(map.At("999") == 1);
+	int count = 0;
+	for (auto iter = map.begin(); iter != map.end(); ++iter) {
+		count++;
+	}
+	STL_CHECK(count == map.Size());
+
+	int live = Tracked::s_live;
+	{
+		FlatUnorderedMap<int, Tracked> tracked;
+		Tracked value(1);
+		for (int i = 0; i < 2; i++) {
+			tracked.Insert({ i, value });
+		}
+		std::pair<const int, Tracked> pair(7, value);
+		Tracked::s_copies_left = 0;
+		STL_CHECK(throws<std::runtime_error>([&tracked, &pair] { tracked.Insert(pair); }));
+		Tracked::s_copies_left = -1;
+		STL_CHECK(tracked.Size() == 2 && Tracked::s_live == live + 4);
+
+		// Copies throwing in the middle of rehashes leave a consistent table.
+		for (int round = 0; round < 20; round++) {
+			Tracked::s_copies_left = 5;
+			try {
+				for (int i = 100; i < 300; i++) {
+					tracked.Insert({ i, value });
+				}
+			}
+			catch (const std::runtime_error&) {}
+			Tracked::s_copies_left = -1;
+		}
+		count = 0;
+		for (auto iter = tracked.begin(); iter != tracked.end(); ++iter) {
+			count++;
+		}
+		STL_CHECK(count == tracked.Size() && Tracked::s_live == live + 2 + tracked.Size());
+
+		Tracked::s_copies_left = 3;
+		STL_CHECK(throws<std::runtime_error>([&tracked] { FlatUnorderedMap<int, Tracked> copy(tracked); }));
+		Tracked::s_copies_left = -1;
+		FlatUnorderedMap<int, Tracked> moved(std::move(tracked));
+		STL_CHECK(tracked.Empty() && moved.Size() == count);
+	}
+	STL_CHECK(Tracked::s_live == live);
+}
+
+void testConcurrentUnorderedMap() {
+	ConcurrentUnorderedMap<int, int> map(8);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&map, t] {
+			for (int i = 0; i < 1000; i++) {
+				map.Insert({ t * 1000 + i, i });
+			}
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	STL_CHECK(map.Size() == 4000 && map.Find(3999).value() == 999 && !map.Find(4000));
+	STL_CHECK(map.Update(0, [](int& p_value) { p_value = 42; }) && map.Find(0).value() == 42);
+	STL_CHECK(map.Erase(0) && !map.Contains(0));
+	STL_CHECK(throws<InvalidValueError>([] { ConcurrentUnorderedMap<int, int> huge((1 << 30) + 1); }));
+}
+
+void testReadMostlyUnorderedMap() {
+	ReadMostlyUnorderedMap<int, int> map;
+	for (int i = 0; i < 1000; i++) {
+		map.Insert({ i, i });
+	}
+	std::atomic<bool> done{ false };
+	std::atomic<int> misses{ 0 };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++) {
+		readers.emplace_back([&map, &done, &misses] {
+			while (!done.load()) {
+				for (int i = 0; i < 1000; i += 7) {
+					if (!map.Contains(i)) {
+						misses++;
+					}
+				}
+			}
+			EpochDomain::ReleaseThreadSlot();
+		});
+	}
+	for (int i = 1000; i < 5000; i++) {
+		map.Insert({ i, i });
+	}
+	done = true;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+	STL_CHECK(misses == 0 && map.Size() == 5000 && map.At(4999) == 4999);
+	STL_CHECK(map.Erase(1) && !map.Find(1));
+}
+
+void testPersistentUnorderedMap() {
+	PersistentUnorderedMap<int, std::string> map;
+	for (int i = 0; i < 100; i++) {
+		map.Insert({ i, std::to_string(i) });
+	}
+	auto snapshot = map.Snapshot();
+	map.Insert({ 100, "100" });
+	map.Erase(0);
+	STL_CHECK(snapshot.Size() == 100 && snapshot.Contains(0) && !snapshot.Contains(100));
+	STL_CHECK(map.Size() == 100 && !map.Contains(0) && map.At(100) == "100");
+}
+
+void testFrozenUnorderedMap() {
+	constexpr auto map = makeFrozenUnorderedMap<int, int>({ { 1, 10 }, { 7, 70 }, { 42, 420 }, { -3, -30 } });
+	static_assert(map.At(42) == 420, "built at compile time");
+	STL_CHECK(map.Size() == 4 && map.TryGet(7) && *map.TryGet(7) == 70 && !map.Contains(8));
+	STL_CHECK(throws<ItemNotFoundError>([&map] { map.At(8); }));
+}
+
+void testIndexedUnorderedMap() {
+	IndexedUnorderedMap<int, int> map;
+	auto& ordered = map.AddOrderedIndex([](int p_value) { return p_value; });
+	auto& hashed = map.AddHashIndex([](int p_value) {
+		if (p_value < 0) {
+			throw std::runtime_error("projection");
+		}
+		return p_value % 3;
+	});
+	for (int i = 0; i < 10; i++) {
+		map.Insert({ i, i });
+	}
+	STL_CHECK(ordered.Range(2, 4).size() == 3 && ordered.RangeOpen(2, 4).size() == 1 && hashed.Count(0) == 4);
+	STL_CHECK(throws<std::runtime_error>([&map] { map.Insert({ 20, -1 }); }));
+	STL_CHECK(map.Size() == 10 && ordered.Size() == 10 && !map.Contains(20));
+	STL_CHECK(throws<IteratorError>([&map] { map.Erase(map.end()); }));
+	map.Erase(map.Find(3));
+	STL_CHECK(map.Size() == 9 && ordered.Size() == 9 && hashed.Count(0) == 3);
+}
+
+void testSerialization() {
+	std::string path = (std::filesystem::temp_directory_path() / "stl_tests.bin").string();
+	UnorderedMap<std::string, std::string> map;
+	for (int i = 0; i < 100; i++) {
+		map.Insert({ std::to_string(i), std::string(i, 'x') });
+	}
+	saveUnorderedMap(map, path);
+	{
+		UnorderedMap<std::string, std::string> loaded;
+		loaded.Insert({ "stale", "" });
+		loadUnorderedMap(loaded, path);
+		STL_CHECK(loaded.Size() == 100 && loaded.At("42") == std::string(42, 'x') && !loaded.Contains("stale"));
+		MappedUnorderedMap<std::string, std::string> mapped(path);
+		STL_CHECK(mapped.Size() == 100 && mapped.At("7") == std::string(7, 'x') && !mapped.Find("100"));
+	}
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out << "not a map";
+	}
+	STL_CHECK(throws<InvalidValueError>([&path] { MappedUnorderedMap<std::string, std::string> mapped(path); }));
+	std::filesystem::remove(path);
+}
+
+void testInternedString() {
+	InternedString name("smoke test string");
+	int size = StringPool::Default().Size();
+	STL_CHECK(InternedString::Find("smoke test string") == name);
+	STL_CHECK(!InternedString::Find("never interned") && StringPool::Default().Size() == size);
+}
+
+void testAlgorithms() {
+	std::vector<int> ints;
+	for (int i = 0; i < 20000; i++) {
+		ints.push_back((i * 7919) % 20011 - 10000);
+	}
+	std::vector<int> sorted = ints;
+	::sort(sorted.begin(), sorted.end());
+	STL_CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+	std::vector<int> radix = ints;
+	radixSort(radix.begin(), radix.end());
+	STL_CHECK(radix == sorted);
+	std::vector<int> parallel = ints;
+	parallelSort(ParallelPolicy(4, 256), parallel.begin(), parallel.end());
+	STL_CHECK(parallel == sorted);
+
+	std::vector<std::pair<double, int>> records;
+	for (int i = 0; i < 1000; i++) {
+		records.push_back({ (i % 10) - 4.5, i });
+	}
+	radixSort(records.begin(), records.end(), [](const std::pair<double, int>& p_record) { return p_record.first; });
+	bool stable = true;
+	for (size_t i = 1; i < records.size(); i++) {
+		stable = stable && (records[i - 1].first < records[i].first ||
+			(records[i - 1].first == records[i].first && records[i - 1].second < records[i].second));
+	}
+	STL_CHECK(stable);
+	stableSort(records.begin(), records.end(), [](const std::pair<double, int>& p_lhs, const std::pair<double, int>& p_rhs) {
+		return p_lhs.second < p_rhs.second;
+	});
+	STL_CHECK(records.front().second == 0 && records.back().second == 999);
+
+	std::vector<double> doubles(10000);
+	for (size_t i = 0; i < doubles.size(); i++) {
+		doubles[i] = static_cast<double>((i * 31) % 10007);
+	}
+	const double* data = doubles.data();
+	STL_CHECK(*minElement(data, data + doubles.size()) == 0.0);
+	STL_CHECK(*maxElement(data, data + doubles.size()) == 10006.0);
+	STL_CHECK(findIf(data, data + doubles.size(), EqualTo<double>{ 31.0 }) == data + 1);
+	ParallelPolicy policy(4, 256);
+	STL_CHECK(*minElement(policy, doubles.begin(), doubles.end()) == 0.0);
+	STL_CHECK(findIf(policy, doubles.begin(), doubles.end(), [](double p_value) { return p_value == 62.0; }) == doubles.begin() + 2);
+	std::vector<double> copied;
+	copyIf(policy, doubles.begin(), doubles.end(), std::back_inserter(copied), [](double p_value) { return p_value < 10; });
+	STL_CHECK(copied.size() == 10);
+
+	UnorderedMap<int, int> map;
+	for (int i = 0; i < 5000; i++) {
+		map.Insert({ i, i });
+	}
+	std::atomic<long long> sum{ 0 };
+	forEach(policy, map, [&sum](std::pair<const int, int>& p_pair) { sum += p_pair.second; });
+	STL_CHECK(sum == 5000LL * 4999 / 2);
+	STL_CHECK(findIf(policy, map, [](const std::pair<const int, int>& p_pair) { return p_pair.second == 4321; })->first == 4321);
+	STL_CHECK(maxElement(policy, map)->first == 4999);
+}
+
+}
+
+
+int main() {
+	testUnorderedMap();
+	testEmplaceExceptions();
+	testFlatUnorderedMap();
+	testConcurrentUnorderedMap();
+	testReadMostlyUnorderedMap();
+	testPersistentUnorderedMap();
+	testFrozenUnorderedMap();
+	testIndexedUnorderedMap();
+	testSerialization();
+	testInternedString();
+	testAlgorithms();
+	std::printf(g_failures ? "%d checks failed\n" : "all checks passed\n", g_failures);
+	return g_failures;
+}